@@ -0,0 +1,176 @@
+/*
+ * Feasibility.hpp - fixed-priority feasibility tests and multi-core
+ * partitioning for Sequencer services
+ *
+ * responseTime()/isFeasible() are the completion test (Joseph & Pandya
+ * response-time analysis) from assignment-2/Feasibility_tests/RM, moved to
+ * nanosecond durations and to explicit priorities: services are analysed in
+ * SCHED_FIFO priority order, which is rate monotonic when priorities were
+ * assigned by period.
+ *
+ * partition() assigns services to cores the way the multi-core references
+ * in that file describe (Bertossi et al., Burchard et al.): sort by
+ * decreasing utilization, then place each service on the first core
+ * (first-fit) or the fullest core (best-fit) on which the completion test
+ * still passes for every service already there.
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+// What the analysis needs to know about one service
+struct TaskModel
+{
+    std::chrono::nanoseconds period{0};
+    std::chrono::nanoseconds wcet{0};
+    std::chrono::nanoseconds deadline{0}; // zero: deadline == period
+    int                      priority = 0; // SCHED_FIFO priority, higher runs first
+
+    std::chrono::nanoseconds effectiveDeadline() const
+    {
+        return deadline.count() > 0 ? deadline : period;
+    }
+
+    double utilization() const
+    {
+        return period.count() > 0 ? static_cast<double>(wcet.count()) / static_cast<double>(period.count())
+                                  : 0.0;
+    }
+};
+
+// True if a is analysed before (has higher priority than) b; equal
+// priorities are broken rate monotonic, shorter period first
+inline bool higherPriority(const TaskModel& a, const TaskModel& b)
+{
+    if (a.priority != b.priority) {
+        return a.priority > b.priority;
+    }
+    return a.period < b.period;
+}
+
+// Worst-case response time of task under preemption by higherPriorityTasks:
+// iterate a = C + sum(ceil(a / T_j) * C_j) to its fixed point. Returns
+// nothing if the iteration passes the deadline (task is not schedulable).
+inline std::optional<std::chrono::nanoseconds> responseTime(const std::vector<TaskModel>& higherPriorityTasks,
+                                                            const TaskModel& task)
+{
+    using std::chrono::nanoseconds;
+
+    nanoseconds response = task.wcet;
+    for (const auto& hp : higherPriorityTasks) {
+        response += hp.wcet;
+    }
+
+    for (;;) {
+        if (response > task.effectiveDeadline()) {
+            return std::nullopt;
+        }
+        nanoseconds next = task.wcet;
+        for (const auto& hp : higherPriorityTasks) {
+            if (hp.period.count() <= 0) {
+                continue;
+            }
+            next += ((response + hp.period - nanoseconds{1}) / hp.period) * hp.wcet;
+        }
+        if (next == response) {
+            return response;
+        }
+        response = next;
+    }
+}
+
+// Completion test for a set of services sharing one core
+inline bool isFeasible(std::vector<TaskModel> tasks)
+{
+    std::sort(tasks.begin(), tasks.end(), higherPriority);
+    std::vector<TaskModel> higher;
+    for (const auto& task : tasks) {
+        if (!responseTime(higher, task)) {
+            return false;
+        }
+        higher.push_back(task);
+    }
+    return true;
+}
+
+enum class PartitionHeuristic
+{
+    FirstFitDecreasing, // lowest-numbered core that stays feasible
+    BestFitDecreasing   // feasible core left with the least spare utilization
+};
+
+struct PartitionResult
+{
+    std::vector<int>    core;        // per task, -1 if no core could take it
+    std::vector<double> utilization; // per core, including pre-placed tasks
+    bool                feasible = true;
+};
+
+// Partition tasks over cores. preplaced[i] >= 0 pins task i to that core
+// (it still loads the core); tasks with preplaced[i] < 0 are placed. A task
+// pinned to a core outside 0..cores-1 keeps that core in result.core but
+// cannot be analysed, so the result is infeasible.
+inline PartitionResult partition(const std::vector<TaskModel>& tasks, const std::vector<int>& preplaced,
+                                 size_t cores, PartitionHeuristic heuristic)
+{
+    PartitionResult result;
+    result.core.assign(tasks.size(), -1);
+    result.utilization.assign(cores, 0.0);
+    std::vector<std::vector<TaskModel>> coreTasks(cores);
+
+    std::vector<size_t> toPlace;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        if (preplaced[i] >= 0 && static_cast<size_t>(preplaced[i]) < cores) {
+            result.core[i] = preplaced[i];
+            coreTasks[preplaced[i]].push_back(tasks[i]);
+            result.utilization[preplaced[i]] += tasks[i].utilization();
+        } else if (preplaced[i] >= 0) {
+            result.core[i] = preplaced[i];
+            result.feasible = false; // pinned outside the cores analysed
+        } else {
+            toPlace.push_back(i);
+        }
+    }
+    for (size_t c = 0; c < cores; c++) {
+        if (!isFeasible(coreTasks[c])) {
+            result.feasible = false; // the pinned services alone overload it
+        }
+    }
+
+    // Decreasing utilization, the heaviest service first
+    std::stable_sort(toPlace.begin(), toPlace.end(), [&](size_t a, size_t b) {
+        return tasks[a].utilization() > tasks[b].utilization();
+    });
+
+    for (size_t i : toPlace) {
+        int chosen = -1;
+        for (size_t c = 0; c < cores; c++) {
+            auto candidate = coreTasks[c];
+            candidate.push_back(tasks[i]);
+            if (!isFeasible(candidate)) {
+                continue;
+            }
+            if (heuristic == PartitionHeuristic::FirstFitDecreasing) {
+                chosen = static_cast<int>(c);
+                break;
+            }
+            if (chosen < 0 || result.utilization[c] > result.utilization[chosen]) {
+                chosen = static_cast<int>(c);
+            }
+        }
+        if (chosen < 0) {
+            result.feasible = false;
+            continue;
+        }
+        result.core[i] = chosen;
+        coreTasks[chosen].push_back(tasks[i]);
+        result.utilization[chosen] += tasks[i].utilization();
+    }
+    return result;
+}
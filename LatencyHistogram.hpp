@@ -0,0 +1,233 @@
+/*
+ * LatencyHistogram.hpp - fixed-footprint log-linear latency histogram
+ *
+ * HDR-style layout: values below 2^kSubBucketBits ns get one bucket each,
+ * above that every power of two is split into 2^(kSubBucketBits-1) linear
+ * sub-buckets, so any recorded value is off by less than 1/64 (1.6%) of
+ * itself. Values from 1 ns up to 2^kMaxValueBits ns (~18 minutes) fit in a
+ * fixed array of counters; larger values are clamped into the last bucket.
+ *
+ * record() is wait-free (one relaxed fetch_add plus min/max stores) and is
+ * meant to be called by a single writer thread; any thread may read,
+ * compute percentiles or export while the writer is recording.
+ * Histograms with the same layout merge by adding counters, so results
+ * from several runs can be combined, either here with merge()/importCsv()
+ * or offline in hist.py.
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned kSubBucketBits = 7;
+    static constexpr unsigned kMaxValueBits  = 40;
+    static constexpr uint64_t kSubBucketCount = 1ULL << kSubBucketBits;
+    static constexpr uint64_t kHalfCount      = kSubBucketCount / 2;
+    static constexpr uint64_t kMaxValue       = (1ULL << kMaxValueBits) - 1;
+    static constexpr size_t   kBucketCount    =
+        kSubBucketCount + (kMaxValueBits - kSubBucketBits) * kHalfCount;
+
+    // Record one value in ns; single writer
+    void record(uint64_t valueNs)
+    {
+        if (valueNs > kMaxValue) {
+            valueNs = kMaxValue;
+        }
+        _counts[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+        if (valueNs < _min.load(std::memory_order_relaxed)) {
+            _min.store(valueNs, std::memory_order_relaxed);
+        }
+        if (valueNs > _max.load(std::memory_order_relaxed)) {
+            _max.store(valueNs, std::memory_order_relaxed);
+        }
+        _sum.fetch_add(valueNs, std::memory_order_relaxed);
+        _total.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Negative latencies (e.g. a release that fired early) count as zero
+    void recordSigned(int64_t valueNs)
+    {
+        record(valueNs < 0 ? 0 : static_cast<uint64_t>(valueNs));
+    }
+
+    uint64_t count() const { return _total.load(std::memory_order_relaxed); }
+    uint64_t min() const   { return count() == 0 ? 0 : _min.load(std::memory_order_relaxed); }
+    uint64_t max() const   { return _max.load(std::memory_order_relaxed); }
+
+    double mean() const
+    {
+        uint64_t total = count();
+        return total == 0 ? 0.0
+                          : static_cast<double>(_sum.load(std::memory_order_relaxed)) / total;
+    }
+
+    // Smallest value v such that at least percentile% of the samples are
+    // <= v, reported as the upper edge of its bucket (clipped to max())
+    uint64_t valueAtPercentile(double percentile) const
+    {
+        uint64_t total = count();
+        if (total == 0) {
+            return 0;
+        }
+        double wanted = percentile / 100.0 * static_cast<double>(total);
+        uint64_t rank = static_cast<uint64_t>(wanted);
+        if (static_cast<double>(rank) < wanted || rank == 0) {
+            rank++;
+        }
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; i++) {
+            seen += _counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t high = bucketHigh(i);
+                return high < max() ? high : max();
+            }
+        }
+        return max();
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < kBucketCount; i++) {
+            uint64_t n = other._counts[i].load(std::memory_order_relaxed);
+            if (n != 0) {
+                _counts[i].fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+        if (other.count() != 0) {
+            if (other.min() < _min.load(std::memory_order_relaxed)) {
+                _min.store(other.min(), std::memory_order_relaxed);
+            }
+            if (other.max() > max()) {
+                _max.store(other.max(), std::memory_order_relaxed);
+            }
+        }
+        _sum.fetch_add(other._sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _total.fetch_add(other.count(), std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        for (auto& bucket : _counts) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        _min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+        _sum.store(0, std::memory_order_relaxed);
+        _total.store(0, std::memory_order_relaxed);
+    }
+
+    // One line: count, min, mean, percentiles and max in microseconds
+    std::string summary() const
+    {
+        std::ostringstream out;
+        out.setf(std::ios::fixed);
+        out.precision(3);
+        auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+        out << "n=" << count()
+            << " min=" << us(min())
+            << " avg=" << mean() / 1000.0
+            << " p50=" << us(valueAtPercentile(50.0))
+            << " p90=" << us(valueAtPercentile(90.0))
+            << " p99=" << us(valueAtPercentile(99.0))
+            << " p99.9=" << us(valueAtPercentile(99.9))
+            << " p99.99=" << us(valueAtPercentile(99.99))
+            << " max=" << us(max());
+        return out.str();
+    }
+
+    // Append the non-empty buckets as "metric,low_ns,high_ns,count" rows.
+    // Write kCsvHeader once at the top of the file first.
+    static constexpr const char* kCsvHeader = "# metric,low_ns,high_ns,count";
+
+    void exportCsv(std::ostream& out, const std::string& metric) const
+    {
+        for (size_t i = 0; i < kBucketCount; i++) {
+            uint64_t n = _counts[i].load(std::memory_order_relaxed);
+            if (n != 0) {
+                out << metric << ',' << bucketLow(i) << ',' << bucketHigh(i) << ',' << n << '\n';
+            }
+        }
+    }
+
+    // Add the rows for metric from a previous exportCsv() to this
+    // histogram (bucket midpoints stand in for the unknown exact values)
+    void importCsv(std::istream& in, const std::string& metric)
+    {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            std::istringstream row(line);
+            std::string name, low, high, n;
+            if (!std::getline(row, name, ',') || name != metric
+                || !std::getline(row, low, ',') || !std::getline(row, high, ',')
+                || !std::getline(row, n, ',')) {
+                continue;
+            }
+            uint64_t lowNs  = std::stoull(low);
+            uint64_t highNs = std::stoull(high);
+            uint64_t samples = std::stoull(n);
+            uint64_t mid = lowNs + (highNs - lowNs) / 2;
+            _counts[bucketIndex(mid > kMaxValue ? kMaxValue : mid)].fetch_add(samples, std::memory_order_relaxed);
+            if (lowNs < _min.load(std::memory_order_relaxed)) {
+                _min.store(lowNs, std::memory_order_relaxed);
+            }
+            if (highNs > max()) {
+                _max.store(highNs, std::memory_order_relaxed);
+            }
+            _sum.fetch_add(mid * samples, std::memory_order_relaxed);
+            _total.fetch_add(samples, std::memory_order_relaxed);
+        }
+    }
+
+    static size_t bucketIndex(uint64_t valueNs)
+    {
+        if (valueNs < kSubBucketCount) {
+            return static_cast<size_t>(valueNs);
+        }
+        unsigned msb   = static_cast<unsigned>(std::bit_width(valueNs)) - 1;
+        unsigned shift = msb - kSubBucketBits + 1;
+        uint64_t top   = valueNs >> shift; // in [kHalfCount, kSubBucketCount)
+        return static_cast<size_t>(kSubBucketCount + (shift - 1) * kHalfCount + (top - kHalfCount));
+    }
+
+    static uint64_t bucketLow(size_t index)
+    {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+        uint64_t shift = (index - kSubBucketCount) / kHalfCount + 1;
+        uint64_t top   = (index - kSubBucketCount) % kHalfCount + kHalfCount;
+        return top << shift;
+    }
+
+    static uint64_t bucketHigh(size_t index)
+    {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+        uint64_t shift = (index - kSubBucketCount) / kHalfCount + 1;
+        return bucketLow(index) + (1ULL << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> _counts{};
+    std::atomic<uint64_t> _min{std::numeric_limits<uint64_t>::max()};
+    std::atomic<uint64_t> _max{0};
+    std::atomic<uint64_t> _sum{0};
+    std::atomic<uint64_t> _total{0};
+};
@@ -0,0 +1,303 @@
+/*
+ * PerfCounters.hpp - per-thread hardware and software event counters
+ *
+ * A PerfCounterGroup opens cycles, instructions, L1D and LLC read misses,
+ * branch misses, context switches and page faults with perf_event_open()
+ * for the calling thread, as one event group: the kernel schedules the
+ * group onto the PMU all at once and a single read() returns every count,
+ * so the numbers of one sample belong to the same instructions. Taking a
+ * sample before and after a piece of code gives its deltas.
+ *
+ * Events the machine or kernel does not offer (no PMU in most VMs, or
+ * perf_event_paranoid without CAP_PERFMON) are left out and reported; the
+ * rest still count. If kernel-mode counting is refused, the group falls
+ * back to user mode only, which loses context switches and kernel time.
+ * When the PMU is shared and the group is multiplexed, counts are scaled
+ * by time enabled / time running.
+ *
+ * Usage:
+ *   PerfCounterGroup counters;
+ *   counters.open();                  // on the thread to be measured
+ *   PerfSample before, after;
+ *   counters.read(before);
+ *   work();
+ *   counters.read(after);
+ *   PerfSample delta = after - before;
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "ServiceStats.hpp"
+
+enum class PerfEvent : uint8_t
+{
+    Cycles,
+    Instructions,
+    L1dMisses,
+    LlcMisses,
+    BranchMisses,
+    ContextSwitches,
+    PageFaults
+};
+
+constexpr size_t kPerfEventCount = 7;
+
+inline const char* perfEventName(PerfEvent event)
+{
+    switch (event) {
+    case PerfEvent::Cycles:          return "cycles";
+    case PerfEvent::Instructions:    return "instructions";
+    case PerfEvent::L1dMisses:       return "l1d-misses";
+    case PerfEvent::LlcMisses:       return "llc-misses";
+    case PerfEvent::BranchMisses:    return "branch-misses";
+    case PerfEvent::ContextSwitches: return "context-switches";
+    case PerfEvent::PageFaults:      return "page-faults";
+    default:                         return "unknown";
+    }
+}
+
+// One count per PerfEvent; events that are not open stay zero
+struct PerfSample
+{
+    std::array<uint64_t, kPerfEventCount> values{};
+
+    uint64_t operator[](PerfEvent event) const
+    {
+        return values[static_cast<size_t>(event)];
+    }
+
+    PerfSample operator-(const PerfSample& earlier) const
+    {
+        PerfSample delta;
+        for (size_t i = 0; i < kPerfEventCount; i++) {
+            delta.values[i] = values[i] - earlier.values[i];
+        }
+        return delta;
+    }
+};
+
+// Per-release deltas of one service, written by its thread only
+struct PerfStats
+{
+    MinMaxSum counts[kPerfEventCount];
+
+    // Deltas of the job with the longest execution time, to tell a slow
+    // job's cache misses from its preemptions and page faults
+    int64_t  worstExecNs = 0;
+    uint64_t worst[kPerfEventCount] = {};
+
+    void add(const PerfSample& delta, int64_t execNs)
+    {
+        for (size_t i = 0; i < kPerfEventCount; i++) {
+            counts[i].add(static_cast<int64_t>(delta.values[i]));
+        }
+        if (execNs > worstExecNs) {
+            worstExecNs = execNs;
+            std::memcpy(worst, delta.values.data(), sizeof(worst));
+        }
+    }
+};
+
+// What taking the samples costs: the time of one read() and the counts a
+// back-to-back pair of reads adds to every delta
+struct PerfOverhead
+{
+    double                              readNs = 0.0;
+    std::array<double, kPerfEventCount> perPair{};
+};
+
+// PERF_TYPE_HW_CACHE config for read misses of cache
+constexpr uint64_t perfCacheMissConfig(uint64_t cache)
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup() = default;
+
+    ~PerfCounterGroup()
+    {
+        close();
+    }
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    // Open every event for the calling thread (any CPU) and start counting.
+    // Returns the number of events opened; report() says what happened to
+    // each.
+    size_t open()
+    {
+        close();
+        if (!_openAll(false)) {
+            close();
+            _openAll(true); // kernel-mode counting refused; count user mode only
+            _userOnly = true;
+        }
+        if (_members == 0) {
+            return 0;
+        }
+        ioctl(_fds[_order[0]], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(_fds[_order[0]], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return _members;
+    }
+
+    void close()
+    {
+        for (int& fd : _fds) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        _members = 0;
+        _userOnly = false;
+        _errors.fill(0);
+    }
+
+    bool isOpen() const
+    {
+        return _members > 0;
+    }
+
+    bool isOpen(PerfEvent event) const
+    {
+        return _fds[static_cast<size_t>(event)] >= 0;
+    }
+
+    // "cycles ok, l1d-misses FAILED (No such file or directory), ..."
+    std::string report() const
+    {
+        std::string report;
+        for (size_t i = 0; i < kPerfEventCount; i++) {
+            if (!report.empty()) {
+                report += ", ";
+            }
+            report += std::string(perfEventName(static_cast<PerfEvent>(i))) + " "
+                + (_fds[i] >= 0 ? std::string("ok")
+                                : std::string("FAILED (") + strerror(_errors[i]) + ")");
+        }
+        return _userOnly ? report + " (user mode only)" : report;
+    }
+
+    // Current counts of the whole group with one read() syscall. Must be
+    // called on the thread that opened the group.
+    bool read(PerfSample& sample) const
+    {
+        if (_members == 0) {
+            return false;
+        }
+        // PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING:
+        // nr, time enabled, time running, one value per member in open order
+        uint64_t buffer[3 + kPerfEventCount];
+        ssize_t expected = static_cast<ssize_t>((3 + _members) * sizeof(uint64_t));
+        if (::read(_fds[_order[0]], buffer, sizeof(buffer)) != expected) {
+            return false;
+        }
+        uint64_t enabled = buffer[1];
+        uint64_t running = buffer[2];
+        for (size_t m = 0; m < _members; m++) {
+            uint64_t value = buffer[3 + m];
+            if (running != 0 && running < enabled) {
+                value = static_cast<uint64_t>(static_cast<double>(value) * static_cast<double>(enabled)
+                                              / static_cast<double>(running));
+            }
+            sample.values[_order[m]] = value;
+        }
+        return true;
+    }
+
+    // Time pairs of reads with nothing between them; call on the counting
+    // thread, before the real measurements
+    PerfOverhead measureOverhead(int pairs = 1000) const
+    {
+        PerfOverhead overhead;
+        if (_members == 0 || pairs <= 0) {
+            return overhead;
+        }
+        std::array<uint64_t, kPerfEventCount> totals{};
+        PerfSample before;
+        PerfSample after;
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < pairs; i++) {
+            read(before);
+            read(after);
+            PerfSample delta = after - before;
+            for (size_t e = 0; e < kPerfEventCount; e++) {
+                totals[e] += delta.values[e];
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        overhead.readNs = std::chrono::duration<double, std::nano>(elapsed).count() / (2.0 * pairs);
+        for (size_t e = 0; e < kPerfEventCount; e++) {
+            overhead.perPair[e] = static_cast<double>(totals[e]) / pairs;
+        }
+        return overhead;
+    }
+
+private:
+    // Hardware events first, so a hardware counter leads the group when
+    // there is one; software events can join a hardware group
+    bool _openAll(bool userOnly)
+    {
+        static constexpr struct
+        {
+            PerfEvent event;
+            uint32_t  type;
+            uint64_t  config;
+        } kEvents[kPerfEventCount] = {
+            {PerfEvent::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PerfEvent::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PerfEvent::L1dMisses, PERF_TYPE_HW_CACHE, perfCacheMissConfig(PERF_COUNT_HW_CACHE_L1D)},
+            {PerfEvent::LlcMisses, PERF_TYPE_HW_CACHE, perfCacheMissConfig(PERF_COUNT_HW_CACHE_LL)},
+            {PerfEvent::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PerfEvent::ContextSwitches, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+            {PerfEvent::PageFaults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+        };
+
+        for (const auto& spec : kEvents) {
+            struct perf_event_attr attr{};
+            attr.size           = sizeof(attr);
+            attr.type           = spec.type;
+            attr.config         = spec.config;
+            attr.disabled       = _members == 0 ? 1 : 0; // the leader starts the whole group
+            attr.exclude_hv     = 1;
+            attr.exclude_kernel = userOnly ? 1 : 0;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int leader = _members == 0 ? -1 : _fds[_order[0]];
+            size_t index = static_cast<size_t>(spec.event);
+            int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+            if (fd < 0) {
+                _errors[index] = errno;
+                if (!userOnly && (errno == EACCES || errno == EPERM)) {
+                    return false;
+                }
+                continue;
+            }
+            _fds[index] = fd;
+            _order[_members++] = index;
+        }
+        return true;
+    }
+
+    std::array<int, kPerfEventCount>    _fds{-1, -1, -1, -1, -1, -1, -1};
+    std::array<int, kPerfEventCount>    _errors{};
+    std::array<size_t, kPerfEventCount> _order{}; // event of each group member, in read() order
+    size_t                              _members = 0;
+    bool                                _userOnly = false;
+};
@@ -0,0 +1,174 @@
+/*
+ * ReleasePrimitive.hpp - the wakeup a Sequencer uses to release a service
+ *
+ * A release is a counting handoff: the scheduler thread post()s once per
+ * job and the service thread wait()s for one job at a time. Four
+ * implementations are available so their release-to-running latency can be
+ * compared (see release_latency_bench.cpp):
+ *
+ *   Semaphore - std::counting_semaphore
+ *   Futex     - a raw futex word holding the count; post() only makes a
+ *               syscall when the service thread is actually asleep
+ *   EventFd   - an EFD_SEMAPHORE eventfd; every post() and wait() is a
+ *               write()/read() syscall, but the fd can be polled
+ *   CondVar   - count under a std::mutex plus a std::condition_variable
+ *
+ * Every kind supports one waiting thread and any number of posters.
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <linux/futex.h>
+#include <mutex>
+#include <semaphore>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+enum class ReleasePrimitiveKind
+{
+    Semaphore,
+    Futex,
+    EventFd,
+    CondVar
+};
+
+inline const char* releasePrimitiveName(ReleasePrimitiveKind kind)
+{
+    switch (kind) {
+    case ReleasePrimitiveKind::Semaphore: return "semaphore";
+    case ReleasePrimitiveKind::Futex:     return "futex";
+    case ReleasePrimitiveKind::EventFd:   return "eventfd";
+    case ReleasePrimitiveKind::CondVar:   return "condvar";
+    default:                              return "unknown";
+    }
+}
+
+class ReleasePrimitive
+{
+public:
+    explicit ReleasePrimitive(ReleasePrimitiveKind kind)
+      : _kind(kind)
+    {
+        if (_kind == ReleasePrimitiveKind::EventFd) {
+            _eventFd = eventfd(0, EFD_SEMAPHORE | EFD_CLOEXEC);
+            if (_eventFd < 0) {
+                std::cerr << "ReleasePrimitive: eventfd failed: " << strerror(errno)
+                          << ", using futex instead\n";
+                _kind = ReleasePrimitiveKind::Futex;
+            }
+        }
+    }
+
+    ~ReleasePrimitive()
+    {
+        if (_eventFd >= 0) {
+            close(_eventFd);
+        }
+    }
+
+    ReleasePrimitive(const ReleasePrimitive&) = delete;
+    ReleasePrimitive& operator=(const ReleasePrimitive&) = delete;
+
+    ReleasePrimitiveKind kind() const
+    {
+        return _kind;
+    }
+
+    // Add one release and wake the waiting thread
+    void post()
+    {
+        switch (_kind) {
+        case ReleasePrimitiveKind::Semaphore:
+            _semaphore.release();
+            break;
+        case ReleasePrimitiveKind::Futex:
+            _futexCount.fetch_add(1);
+            if (_futexWaiters.load() > 0) {
+                _futex(FUTEX_WAKE_PRIVATE, 1);
+            }
+            break;
+        case ReleasePrimitiveKind::EventFd: {
+            uint64_t one = 1;
+            while (write(_eventFd, &one, sizeof(one)) < 0 && errno == EINTR) {
+            }
+            break;
+        }
+        case ReleasePrimitiveKind::CondVar: {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _condCount++;
+            }
+            _condition.notify_one();
+            break;
+        }
+        }
+    }
+
+    // Block until a release is available and consume it
+    void wait()
+    {
+        switch (_kind) {
+        case ReleasePrimitiveKind::Semaphore:
+            _semaphore.acquire();
+            break;
+        case ReleasePrimitiveKind::Futex:
+            for (;;) {
+                uint32_t count = _futexCount.load();
+                while (count > 0) {
+                    if (_futexCount.compare_exchange_weak(count, count - 1)) {
+                        return;
+                    }
+                }
+                // Sleep only while the count is still zero; a post() that
+                // lands in between makes FUTEX_WAIT return EAGAIN at once
+                _futexWaiters.fetch_add(1);
+                _futex(FUTEX_WAIT_PRIVATE, 0);
+                _futexWaiters.fetch_sub(1);
+            }
+        case ReleasePrimitiveKind::EventFd: {
+            uint64_t value = 0;
+            while (read(_eventFd, &value, sizeof(value)) < 0 && errno == EINTR) {
+            }
+            break;
+        }
+        case ReleasePrimitiveKind::CondVar: {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]() { return _condCount > 0; });
+            _condCount--;
+            break;
+        }
+        }
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t)
+                  && std::atomic<uint32_t>::is_always_lock_free,
+                  "futex word must be a plain 32-bit integer");
+
+    long _futex(int op, uint32_t value)
+    {
+        return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&_futexCount), op, value,
+                       nullptr, nullptr, 0);
+    }
+
+    ReleasePrimitiveKind _kind;
+
+    std::counting_semaphore<> _semaphore{0};
+
+    std::atomic<uint32_t> _futexCount{0};
+    std::atomic<uint32_t> _futexWaiters{0};
+
+    int _eventFd{-1};
+
+    std::mutex              _mutex;
+    std::condition_variable _condition;
+    uint64_t                _condCount{0};
+};
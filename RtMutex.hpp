@@ -0,0 +1,216 @@
+/*
+ * RtMutex.hpp - priority-inheritance mutex with contention statistics
+ *
+ * std::mutex is a plain futex lock: a low-priority service holding it can
+ * be preempted by medium-priority work while a high-priority service waits
+ * for it, for as long as the medium work runs (unbounded priority
+ * inversion). RtMutex is a pthread mutex with PTHREAD_PRIO_INHERIT, so the
+ * holder runs at the priority of its highest waiter until it unlocks, or
+ * with PTHREAD_PRIO_PROTECT, so the holder always runs at a fixed ceiling.
+ *
+ * It is a drop-in for std::mutex (lock/try_lock/unlock, works with
+ * std::lock_guard and std::unique_lock) and records per lock:
+ *   - acquisitions and contended acquisitions (lock() found it held)
+ *   - wait time of contended acquisitions
+ *   - hold time of every acquisition
+ * Both times go into LatencyHistograms that are only written while the
+ * lock is held, so the lock itself keeps them single-writer. Every RtMutex
+ * registers itself by name; Sequencer::stopServices() prints them all and
+ * Sequencer::exportHistograms() exports "<name>.lock_wait" and
+ * "<name>.lock_hold".
+ *
+ * Usage:
+ *   RtMutex frame_mutex{"frame"};
+ *   RtMutex config_mutex{"config", RtMutexProtocol::Protect, 98};
+ *   std::lock_guard lock(frame_mutex);
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <pthread.h>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+
+enum class RtMutexProtocol
+{
+    Inherit, // PTHREAD_PRIO_INHERIT: holder boosted to its highest waiter
+    Protect  // PTHREAD_PRIO_PROTECT: holder runs at the ceiling priority
+};
+
+inline const char* rtMutexProtocolName(RtMutexProtocol protocol)
+{
+    switch (protocol) {
+    case RtMutexProtocol::Inherit: return "inherit";
+    case RtMutexProtocol::Protect: return "protect";
+    default:                       return "unknown";
+    }
+}
+
+class RtMutex
+{
+public:
+    // ceiling is the SCHED_FIFO priority for Protect, ignored for Inherit.
+    // Throws std::system_error if the mutex cannot be created.
+    explicit RtMutex(std::string name, RtMutexProtocol protocol = RtMutexProtocol::Inherit, int ceiling = 0)
+      : _name(std::move(name)),
+        _protocol(protocol),
+        _ceiling(ceiling)
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        int error = pthread_mutexattr_setprotocol(
+            &attr, protocol == RtMutexProtocol::Protect ? PTHREAD_PRIO_PROTECT : PTHREAD_PRIO_INHERIT);
+        if (error == 0 && protocol == RtMutexProtocol::Protect) {
+            error = pthread_mutexattr_setprioceiling(&attr, ceiling);
+        }
+        if (error == 0) {
+            error = pthread_mutex_init(&_mutex, &attr);
+        }
+        pthread_mutexattr_destroy(&attr);
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(), "RtMutex " + _name);
+        }
+        _registry().add(this);
+    }
+
+    ~RtMutex()
+    {
+        _registry().remove(this);
+        pthread_mutex_destroy(&_mutex);
+    }
+
+    RtMutex(const RtMutex&) = delete;
+    RtMutex& operator=(const RtMutex&) = delete;
+
+    // Throws std::system_error like std::mutex::lock(), e.g. EINVAL when a
+    // thread above the ceiling locks a Protect mutex
+    void lock()
+    {
+        int error = pthread_mutex_trylock(&_mutex);
+        if (error == EBUSY) {
+            auto waitStart = std::chrono::steady_clock::now();
+            error = pthread_mutex_lock(&_mutex);
+            if (error == 0) {
+                _acquiredAt = std::chrono::steady_clock::now();
+                _contended.fetch_add(1, std::memory_order_relaxed);
+                _waitHist.recordSigned((_acquiredAt - waitStart).count());
+            }
+        } else if (error == 0) {
+            _acquiredAt = std::chrono::steady_clock::now();
+        }
+        if (error != 0) {
+            throw std::system_error(error, std::generic_category(), "RtMutex " + _name + " lock");
+        }
+        _acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool try_lock()
+    {
+        if (pthread_mutex_trylock(&_mutex) != 0) {
+            return false;
+        }
+        _acquiredAt = std::chrono::steady_clock::now();
+        _acquisitions.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void unlock()
+    {
+        _holdHist.recordSigned((std::chrono::steady_clock::now() - _acquiredAt).count());
+        pthread_mutex_unlock(&_mutex);
+    }
+
+    const std::string& name() const { return _name; }
+    RtMutexProtocol protocol() const { return _protocol; }
+    uint64_t acquisitions() const { return _acquisitions.load(std::memory_order_relaxed); }
+    uint64_t contended() const { return _contended.load(std::memory_order_relaxed); }
+    const LatencyHistogram& waitTime() const { return _waitHist; }
+    const LatencyHistogram& holdTime() const { return _holdHist; }
+
+    void printStats(std::ostream& out) const
+    {
+        uint64_t total = acquisitions();
+        out << "Lock Stats: " << _name << " (" << rtMutexProtocolName(_protocol);
+        if (_protocol == RtMutexProtocol::Protect) {
+            out << ", ceiling=" << _ceiling;
+        }
+        out << ")\n  Acquisitions: " << total << ", contended " << contended() << " ("
+            << (total == 0 ? 0.0 : 100.0 * static_cast<double>(contended()) / static_cast<double>(total))
+            << "%)\n";
+        out << "  Wait Time (us): " << _waitHist.summary() << "\n";
+        out << "  Hold Time (us): " << _holdHist.summary() << "\n";
+    }
+
+    // Append "<name>.lock_wait" and "<name>.lock_hold" histogram rows
+    void exportHistograms(std::ostream& out) const
+    {
+        _waitHist.exportCsv(out, _name + ".lock_wait");
+        _holdHist.exportCsv(out, _name + ".lock_hold");
+    }
+
+    // Visit every live RtMutex in creation order (cold path)
+    static void forEach(const std::function<void(const RtMutex&)>& visit)
+    {
+        _registry().forEach(visit);
+    }
+
+private:
+    class Registry
+    {
+    public:
+        void add(RtMutex* mutex)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _mutexes.push_back(mutex);
+        }
+
+        void remove(RtMutex* mutex)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _mutexes.erase(std::remove(_mutexes.begin(), _mutexes.end(), mutex), _mutexes.end());
+        }
+
+        void forEach(const std::function<void(const RtMutex&)>& visit)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const RtMutex* mutex : _mutexes) {
+                visit(*mutex);
+            }
+        }
+
+    private:
+        std::mutex            _mutex;
+        std::vector<RtMutex*> _mutexes;
+    };
+
+    static Registry& _registry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    pthread_mutex_t _mutex;
+    std::string     _name;
+    RtMutexProtocol _protocol;
+    int             _ceiling;
+
+    // Written by the holder only
+    std::chrono::steady_clock::time_point _acquiredAt;
+    LatencyHistogram                      _waitHist;
+    LatencyHistogram                      _holdHist;
+
+    std::atomic<uint64_t> _acquisitions{0};
+    std::atomic<uint64_t> _contended{0};
+};
@@ -272,6 +272,8 @@ int main(){
     std::signal(SIGINT, signalHandler);
 
     Sequencer sequencer;
+    // Wake the scheduler only when a service's timerfd fires
+    sequencer.setReleaseBackend(Sequencer::ReleaseBackend::TimerFd);
     
 
     // Uncomment the method you want to use:
@@ -299,6 +301,7 @@ int main(){
     
     std::puts("Stopping services...");
     sequencer.stopServices();
+    sequencer.exportHistograms("service_hist.csv"); // plot with: python3 hist.py --hdr service_hist.csv
     //system("echo 0 > /sys/class/gpio/gpio529/value");
     
     return 0;
@@ -40,327 +40,3565 @@
  
  #include <limits>
  
+ #include <algorithm>
+ 
+ #include <numeric>
+ 
+ #include <ctime>
+ 
+ #include <cerrno>
+ 
+ #include <cstring>
+ 
+ #include <sys/timerfd.h>
+ 
+ #include <sys/epoll.h>
+ 
+ #include <sys/eventfd.h>
+ 
+ #include <unistd.h>
+ 
+ #include <string>
+ 
+ #include <pthread.h>
+ 
+ #include <sched.h>
+ 
+ #include <sys/mman.h>
+ 
+ #include <alloca.h>
+ 
+ #include <csignal>
+ 
+ #include <sys/syscall.h>
+ 
+ 
+ 
+ #include <fstream>
+ 
+ #include <optional>
+ 
+ #include <ostream>
+ 
+ 
+ 
+ #include "ServiceStats.hpp"
+ 
+ #include "LatencyHistogram.hpp"
+ 
+ #include "ReleasePrimitive.hpp"
+ 
+ #include "Feasibility.hpp"
+ 
+ #include "TraceBuffer.hpp"
+ 
+ #include "PerfCounters.hpp"
+ 
+ #include "RtMutex.hpp"
+ 
+ #include "WakeableSleep.hpp"
+ 
+ 
+ 
+ // Pass as a service's affinity to leave it unpinned until
+ 
+ // Sequencer::partitionServices() assigns it a core (Sequencer::tryAddService()
+ 
+ // places it as it admits it instead)
+ 
+ constexpr uint8_t kAutoAffinity = 0xFF;
+ 
+ 
+ 
+ // What release() does when the previous job of a service has not finished
+ 
+ // yet (an overrun). Every overrun is counted whatever the policy.
+ 
+ enum class OverrunPolicy
+ 
+ {
+ 
+     Skip,    // drop the release; the service next runs at the following period
+ 
+     Queue,   // keep up to ServiceOptions::maxQueuedReleases pending jobs, drop beyond
+ 
+     CatchUp  // keep every release, including periods the sequencer itself missed,
+ 
+              // and run them back to back until the service is on schedule again
+ 
+ };
+ 
+ 
+ 
+ inline const char* overrunPolicyName(OverrunPolicy policy)
+ 
+ {
+ 
+     switch (policy) {
+ 
+     case OverrunPolicy::Skip:    return "skip";
+ 
+     case OverrunPolicy::Queue:   return "queue";
+ 
+     case OverrunPolicy::CatchUp: return "catch-up";
+ 
+     default:                     return "unknown";
+ 
+     }
+ 
+ }
+ 
+ 
+ 
+ // What happens when a job has used up ServiceOptions::cpuBudget of CPU time
+ 
+ enum class BudgetAction
+ 
+ {
+ 
+     Log,    // report the overrun on stderr once the job returns
+ 
+     Demote, // drop the thread to SCHED_IDLE for the rest of the job
+ 
+     Abort   // raise Service::abortRequested(); the body is expected to check it
+ 
+             // in its long loops and return early
+ 
+ };
+ 
+ 
+ 
+ inline const char* budgetActionName(BudgetAction action)
+ 
+ {
+ 
+     switch (action) {
+ 
+     case BudgetAction::Log:    return "log";
+ 
+     case BudgetAction::Demote: return "demote";
+ 
+     case BudgetAction::Abort:  return "abort";
+ 
+     default:                   return "unknown";
+ 
+     }
+ 
+ }
+ 
+ 
+ 
+ // Signal the per-thread CPU-time budget timers are delivered with
+ 
+ inline int budgetSignal()
+ 
+ {
+ 
+     return SIGRTMIN + 1;
+ 
+ }
+ 
+ 
+ 
+ // Real-time initialization profile applied by each service thread when it
+ 
+ // starts. The defaults are what every service in this repo wants; pass a
+ 
+ // modified copy as the last addService() argument to change them.
+ 
+ struct ServiceOptions
+ 
+ {
+ 
+     int    policy             = SCHED_FIFO; // SCHED_FIFO, SCHED_RR or SCHED_DEADLINE
+ 
+     bool   lockMemory         = true;       // mlockall(MCL_CURRENT | MCL_FUTURE)
+ 
+     size_t prefaultStackBytes = 64 * 1024;  // stack touched up front so releases never page-fault
+ 
+ 
+ 
+     // SCHED_DEADLINE reservation (policy == SCHED_DEADLINE only). The
+ 
+     // reservation period is the service period; a zero deadline means
+ 
+     // deadline == period.
+ 
+     std::chrono::nanoseconds deadlineRuntime{0};
+ 
+     std::chrono::nanoseconds deadlineDeadline{0};
+ 
+ 
+ 
+     // Label used in stats and exported histograms ("service<N>" if empty)
+ 
+     std::string name;
+ 
+ 
+ 
+     // Overrun handling; maxQueuedReleases counts jobs waiting behind the
+ 
+     // running one (Queue only, capped by ReleaseQueue::kCapacity - 1)
+ 
+     OverrunPolicy overrunPolicy     = OverrunPolicy::Skip;
+ 
+     uint32_t      maxQueuedReleases = 1;
+ 
+ 
+ 
+     // Offset of this service's release grid: releases happen at
+ 
+     // start + phase + k*period (k >= 1). Staggering phases keeps services
+ 
+     // with a common period from all being released in one burst.
+ 
+     std::chrono::nanoseconds phase{0};
+ 
+ 
+ 
+     // How release() wakes the service thread. The futex word had the
+ 
+     // lowest release-to-running tail in release_latency_bench and skips
+ 
+     // the wake syscall when the service is still busy.
+ 
+     ReleasePrimitiveKind releasePrimitive = ReleasePrimitiveKind::Futex;
+ 
+ 
+ 
+     // Declared worst-case execution time, used by admission control until
+ 
+     // a longer execution has been measured; zero means measured only
+ 
+     std::chrono::nanoseconds wcet{0};
+ 
+ 
+ 
+     // CPU time one job may use before budgetAction fires, measured on the
+ 
+     // service thread's CPU-time clock (preemption does not count); zero
+ 
+     // means no budget. The kernel checks CPU-time timers at the scheduler
+ 
+     // tick, so the action can come up to one tick late. Not applied to
+ 
+     // SCHED_DEADLINE services, which the kernel throttles itself.
+ 
+     std::chrono::nanoseconds cpuBudget{0};
+ 
+     BudgetAction             budgetAction = BudgetAction::Log;
+ 
+ 
+ 
+     // Per-release deltas of cycles, instructions, cache and branch misses,
+ 
+     // context switches and page faults (PerfCounters.hpp) around the
+ 
+     // service body. Costs two read() syscalls per release; that cost is
+ 
+     // measured at startup and printed with the stats.
+ 
+     bool perfCounters = false;
+ 
+ };
+ 
+ 
+ 
+ // glibc has no sched_setattr() wrapper, so mirror the kernel's struct
+ 
+ // sched_attr (include/uapi/linux/sched/types.h) and use the raw syscall
+ 
+ struct SchedAttr
+ 
+ {
+ 
+     uint32_t size;
+ 
+     uint32_t schedPolicy;
+ 
+     uint64_t schedFlags;
+ 
+     int32_t  schedNice;
+ 
+     uint32_t schedPriority;
+ 
+     uint64_t schedRuntime;  // ns
+ 
+     uint64_t schedDeadline; // ns
+ 
+     uint64_t schedPeriod;   // ns
+ 
+ };
+ 
+ 
+ 
+ // Ask the kernel to send SIGXCPU whenever the task overruns its runtime
+ 
+ constexpr uint64_t kSchedFlagDlOverrun = 0x04;
+ 
+ 
+ 
+ // Switch the calling thread to SCHED_DEADLINE. Returns 0 or the errno; EBUSY
+ 
+ // means the kernel's admission test rejected the reservation.
+ 
+ inline int setSchedDeadline(std::chrono::nanoseconds runtime, std::chrono::nanoseconds deadline,
+ 
+                             std::chrono::nanoseconds period, uint64_t flags)
+ 
+ {
+ 
+     SchedAttr attr{};
+ 
+     attr.size          = sizeof(attr);
+ 
+     attr.schedPolicy   = SCHED_DEADLINE;
+ 
+     attr.schedFlags    = flags;
+ 
+     attr.schedRuntime  = static_cast<uint64_t>(runtime.count());
+ 
+     attr.schedDeadline = static_cast<uint64_t>(deadline.count());
+ 
+     attr.schedPeriod   = static_cast<uint64_t>(period.count());
+ 
+     if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0) {
+ 
+         return errno;
+ 
+     }
+ 
+     return 0;
+ 
+ }
+ 
+ 
+ 
+ // Human readable outcome of one initialization step
+ 
+ inline std::string rtStepResult(int error)
+ 
+ {
+ 
+     return error == 0 ? "ok" : std::string("FAILED (") + strerror(error) + ")";
+ 
+ }
+ 
+ 
+ 
+ inline const char* policyName(int policy)
+ 
+ {
+ 
+     switch (policy) {
+ 
+     case SCHED_FIFO:  return "SCHED_FIFO";
+ 
+     case SCHED_RR:    return "SCHED_RR";
+ 
+     case SCHED_DEADLINE: return "SCHED_DEADLINE";
+ 
+     case SCHED_OTHER: return "SCHED_OTHER";
+ 
+     default:          return "unknown";
+ 
+     }
+ 
+ }
+ 
  
  
  class Service
  
- {
+ {
+ 
+ public:
+ 
+     // period may be any std::chrono duration down to nanoseconds
+ 
+     template<typename T>
+ 
+     Service(T&& doService, uint8_t affinity, uint8_t priority, std::chrono::nanoseconds period,
+ 
+             ServiceOptions options = {})
+ 
+       : _doService(doService),
+ 
+         _affinity(affinity),
+ 
+         _autoAffinity(affinity == kAutoAffinity),
+ 
+         _priority(priority),
+ 
+         _period(period),
+ 
+         _options(options),
+ 
+         _releasePrimitive(options.releasePrimitive),
+ 
+         _runningFlag(true),
+ 
+         _maxOutstanding(_outstandingLimit(options))
+ 
+     {
+ 
+         // Start the service thread, which will run _provideService()
+ 
+         _service = std::jthread(&Service::_provideService, this);
+ 
+     }
+ 
+ 
+ 
+     // period in milliseconds
+ 
+     template<typename T>
+ 
+     Service(T&& doService, uint8_t affinity, uint8_t priority, uint32_t period,
+ 
+             ServiceOptions options = {})
+ 
+       : Service(std::forward<T>(doService), affinity, priority,
+ 
+                 std::chrono::milliseconds(period), std::move(options))
+ 
+     {
+ 
+     }
+ 
+ 
+ 
+     void stop(){
+ 
+         // Signal the thread to stop
+ 
+         _runningFlag = false;
+ 
+         // Post a release in case the thread is waiting, and end a
+ 
+         // rate-limit wait in case it is waiting for a triggered release
+ 
+         _releasePrimitive.post();
+ 
+         _stopWake.release();
+ 
+     }
+ 
+ 
+ 
+     // Wait for the service thread to exit after stop()
+ 
+     void join()
+ 
+     {
+ 
+         if (_service.joinable()) {
+ 
+             _service.join();
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     void release(){
+ 
+         // A manual release has no schedule to be late against
+ 
+         release(std::chrono::steady_clock::now());
+ 
+     }
+ 
+ 
+ 
+     // Release the service for the scheduled instant intendedTime. The
+ 
+     // difference between now and intendedTime is the release lateness.
+ 
+     // Releases must come from one thread at a time, which is then the
+ 
+     // only writer of the release-side stats: the sequencer's scheduler
+ 
+     // thread for a periodic service, the predecessors' service threads
+ 
+     // under _triggerMutex (trigger()) for a triggered one. The sequencer
+ 
+     // never releases a triggered service itself, so the two never mix;
+ 
+     // do not release() a triggered service by hand. Returns false if the
+ 
+     // overrun policy dropped the release.
+ 
+     bool release(std::chrono::steady_clock::time_point intendedTime){
+ 
+         // Record the release time for jitter calculations
+ 
+         auto releaseTime = std::chrono::steady_clock::now();
+ 
+         auto latenessNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+ 
+             releaseTime - intendedTime
+ 
+         ).count();
+ 
+ 
+ 
+         // Release lateness stats. A rate-limited trigger() releases ahead
+ 
+         // of intendedTime on purpose; that is not a lateness sample.
+ 
+         if (latenessNs >= 0) {
+ 
+             _releaseWorking.lateness.add(latenessNs);
+ 
+             _releaseWorking.lastLateness = latenessNs;
+ 
+         }
+ 
+ 
+ 
+         // Any job still queued or running means the service overran
+ 
+         uint32_t outstanding = _outstanding.load(std::memory_order_acquire);
+ 
+         if (outstanding > 0) {
+ 
+             _releaseWorking.overruns++;
+ 
+             _releaseWorking.maxBacklog = std::max<uint64_t>(_releaseWorking.maxBacklog, outstanding);
+ 
+             Tracer::instance().emitAt(TraceEventType::Overrun, _traceSource,
+ 
+                                       releaseTime.time_since_epoch().count(), outstanding);
+ 
+         }
+ 
+         Tracer::instance().emitAt(TraceEventType::Release, _traceSource, releaseTime.time_since_epoch().count(),
+ 
+                                   intendedTime.time_since_epoch().count());
+ 
+         if (outstanding >= _maxOutstanding
+ 
+             || !_releaseQueue.push({intendedTime.time_since_epoch().count(),
+ 
+                                     releaseTime.time_since_epoch().count()})) {
+ 
+             _releaseWorking.droppedReleases++;
+ 
+             _releaseStats.store(_releaseWorking);
+ 
+             return false;
+ 
+         }
+ 
+         _outstanding.fetch_add(1, std::memory_order_release);
+ 
+         _releaseStats.store(_releaseWorking);
+ 
+ 
+ 
+         // Wake the service
+ 
+         _releasePrimitive.post();
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     // Dataflow release, called on a predecessor's service thread when one
+ 
+     // of its jobs completes. The period is a rate limit here: a trigger
+ 
+     // sooner than one period after the previous triggered release is
+ 
+     // released for that later instant, and the service thread waits for it
+ 
+     // before running the job, so the task model (period = minimum
+ 
+     // inter-release time) still holds. Triggers arriving while that job is
+ 
+     // pending are handled by the overrun policy like any other release.
+ 
+     void trigger(std::chrono::steady_clock::time_point completionTime)
+ 
+     {
+ 
+         // A join node has several predecessor threads; _triggerMutex makes
+ 
+         // them release() one at a time
+ 
+         std::lock_guard<std::mutex> lock(_triggerMutex);
+ 
+         auto intendedTime = std::max(completionTime, _lastTriggeredRelease + getPeriod());
+ 
+         if (release(intendedTime)) {
+ 
+             _lastTriggeredRelease = intendedTime;
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Released by trigger() from its predecessors instead of by the
+ 
+     // sequencer's periodic grid (see Sequencer::addPrecedence())
+ 
+     bool isTriggered() const
+ 
+     {
+ 
+         return _triggered;
+ 
+     }
+ 
+ 
+ 
+     void setTriggered(bool triggered)
+ 
+     {
+ 
+         _triggered = triggered;
+ 
+     }
+ 
+ 
+ 
+     // Services to trigger() whenever a job of this one completes (unless
+ 
+     // the job called suppressSuccessors()). Only while the sequencer is
+ 
+     // stopped: the service thread reads the list without a lock.
+ 
+     void addSuccessor(Service* successor)
+ 
+     {
+ 
+         _successors.push_back(successor);
+ 
+     }
+ 
+ 
+ 
+     const std::vector<Service*>& getSuccessors() const
+ 
+     {
+ 
+         return _successors;
+ 
+     }
+ 
+ 
+ 
+     std::chrono::nanoseconds getPeriod() const {
+ 
+         return _period.load(std::memory_order_relaxed);
+ 
+     }
+ 
+ 
+ 
+     // Change the period. The sequencer picks it up when it next releases
+ 
+     // this service: that release stays on the old grid and the following
+ 
+     // one comes a new period later. Safe from any thread.
+ 
+     void setPeriod(std::chrono::nanoseconds period) {
+ 
+         _period.store(period, std::memory_order_relaxed);
+ 
+     }
+ 
+ 
+ 
+     // Change the SCHED_FIFO/RR priority or the core of a running service.
+ 
+     // The service thread applies the change to itself when it wakes for its
+ 
+     // next release, so a running job is never moved. Safe from any thread.
+ 
+     void requestPriority(uint8_t priority) {
+ 
+         _pendingPriority.store(priority, std::memory_order_release);
+ 
+     }
+ 
+ 
+ 
+     void requestAffinity(uint8_t core) {
+ 
+         _pendingAffinity.store(core, std::memory_order_release);
+ 
+     }
+ 
+ 
+ 
+     std::chrono::nanoseconds getPhase() const {
+ 
+         return _options.phase;
+ 
+     }
+ 
+ 
+ 
+     // Only takes effect when the sequencer (re)starts its release grid
+ 
+     void setPhase(std::chrono::nanoseconds phase) {
+ 
+         _options.phase = phase;
+ 
+     }
+ 
+ 
+ 
+     // Longest measured intended release -> completion time so far
+ 
+     std::chrono::nanoseconds getWorstResponseTime() const {
+ 
+         return std::chrono::nanoseconds(_responseTimeHist.max());
+ 
+     }
+ 
+ 
+ 
+     // Longest measured execution time so far (zero before the first run)
+ 
+     std::chrono::nanoseconds getWorstExecutionTime() const {
+ 
+         return std::chrono::nanoseconds(_execTimeHist.max());
+ 
+     }
+ 
+ 
+ 
+     // What feasibility tests assume: the declared WCET, or the worst
+ 
+     // measured execution time if that is longer
+ 
+     TaskModel getTaskModel() const {
+ 
+         return {getPeriod(), std::max(_options.wcet, getWorstExecutionTime()), std::chrono::nanoseconds{0},
+ 
+                 static_cast<int>(_priority.load(std::memory_order_relaxed))};
+ 
+     }
+ 
+ 
+ 
+     uint8_t getPriority() const {
+ 
+         return static_cast<uint8_t>(_priority.load(std::memory_order_relaxed));
+ 
+     }
+ 
+ 
+ 
+     int getPolicy() const {
+ 
+         return _options.policy;
+ 
+     }
+ 
+ 
+ 
+     // Current core, or kAutoAffinity if the service is not pinned yet
+ 
+     uint8_t getAffinity() const {
+ 
+         return static_cast<uint8_t>(_affinity.load());
+ 
+     }
+ 
+ 
+ 
+     // True if the service was added with kAutoAffinity, even once placed
+ 
+     bool isAutoAffinity() const {
+ 
+         return _autoAffinity;
+ 
+     }
+ 
+ 
+ 
+     // Pin the running service thread to core. Returns 0 or the errno.
+ 
+     int setAffinity(uint8_t core) {
+ 
+         cpu_set_t cpuSet;
+ 
+         CPU_ZERO(&cpuSet);
+ 
+         CPU_SET(core, &cpuSet);
+ 
+         int error = pthread_setaffinity_np(_service.native_handle(), sizeof(cpuSet), &cpuSet);
+ 
+         if (error == 0) {
+ 
+             _affinity = core;
+ 
+         }
+ 
+         return error;
+ 
+     }
+ 
+ 
+ 
+     OverrunPolicy getOverrunPolicy() const {
+ 
+         return _options.overrunPolicy;
+ 
+     }
+ 
+ 
+ 
+     // Called by the sequencer when it finds that count whole periods,
+ 
+     // starting at firstMissed, elapsed without a release (e.g. timerfd
+ 
+     // expirations > 1). A catch-up service is released for each of them;
+ 
+     // otherwise they are only counted.
+ 
+     void recordMissedReleases(std::chrono::steady_clock::time_point firstMissed,
+ 
+                               std::chrono::nanoseconds period, uint64_t count){
+ 
+         _releaseWorking.missedReleases += count;
+ 
+         if (_options.overrunPolicy == OverrunPolicy::CatchUp) {
+ 
+             for (uint64_t k = 0; k < count; k++) {
+ 
+                 release(firstMissed + k * period);
+ 
+             }
+ 
+         }
+ 
+         _releaseStats.store(_releaseWorking);
+ 
+     }
+ 
+ 
+ 
+     // Print timing statistics. Works while the service is running too:
+ 
+     // both stat blocks are read as consistent snapshots.
+ 
+     void printStats() {
+ 
+         ReleaseStats   releaseStats = _releaseStats.load();
+ 
+         ExecutionStats execStats    = _execStats.load();
+ 
+         std::string    initReport;
+ 
+         {
+ 
+             std::lock_guard<std::mutex> lock(_statsMutex);
+ 
+             initReport = _initReport;
+ 
+         }
+ 
+ 
+ 
+         // If no samples were collected, just report no data
+ 
+         if (execStats.startJitter.count == 0 || execStats.execTime.count == 0) {
+ 
+             std::cout << "Service Stats: No samples collected.\n";
+ 
+             std::cout << "  RT Init: " << initReport << "\n";
+ 
+             return;
+ 
+         }
+ 
+ 
+ 
+         // Stats are kept in ns; print them in us
+ 
+         auto us = [](double ns) { return ns / 1000.0; };
+ 
+ 
+ 
+         std::cout << "Service Stats:" << (_options.name.empty() ? "" : " " + _options.name)
+ 
+                   << " (period=" << us(getPeriod().count()) << (_triggered ? "us triggered" : "us")
+ 
+                   << ", phase=" << us(_options.phase.count()) << "us, release="
+ 
+                   << releasePrimitiveName(_releasePrimitive.kind()) << ")\n";
+ 
+         std::cout << "  Start Jitter (us):"
+ 
+                   << " min=" << us(execStats.startJitter.min)
+ 
+                   << " max=" << us(execStats.startJitter.max)
+ 
+                   << " avg=" << us(execStats.startJitter.avg())
+ 
+                   << " (based on " << execStats.startJitter.count << " samples)\n";
+ 
+ 
+ 
+         std::cout << "  Execution Time (us):"
+ 
+                   << " min=" << us(execStats.execTime.min)
+ 
+                   << " max=" << us(execStats.execTime.max)
+ 
+                   << " avg=" << us(execStats.execTime.avg())
+ 
+                   << " (based on " << execStats.execTime.count << " samples)\n";
+ 
+ 
+ 
+         // Lateness of each release against its absolute schedule; a drifting
+ 
+         // sequencer shows up as "last" creeping away from "min"
+ 
+         if (releaseStats.lateness.count > 0) {
+ 
+             std::cout << "  Release Lateness (us):"
+ 
+                       << " min=" << us(releaseStats.lateness.min)
+ 
+                       << " max=" << us(releaseStats.lateness.max)
+ 
+                       << " avg=" << us(releaseStats.lateness.avg())
+ 
+                       << " last=" << us(releaseStats.lastLateness)
+ 
+                       << " (based on " << releaseStats.lateness.count << " samples)\n";
+ 
+         }
+ 
+ 
+ 
+         // Distributions, measured from the intended release instant
+ 
+         std::cout << "  Release Latency (us): " << _releaseLatencyHist.summary() << "\n";
+ 
+         std::cout << "  Response Time (us):   " << _responseTimeHist.summary() << "\n";
+ 
+         std::cout << "  Execution Time (us):  " << _execTimeHist.summary() << "\n";
+ 
+         std::cout << "  Missed Releases: " << releaseStats.missedReleases << "\n";
+ 
+         std::cout << "  Overruns: " << releaseStats.overruns
+ 
+                   << " (policy=" << overrunPolicyName(_options.overrunPolicy);
+ 
+         if (_options.overrunPolicy == OverrunPolicy::Queue) {
+ 
+             std::cout << "/" << _maxOutstanding - 1;
+ 
+         }
+ 
+         std::cout << ", dropped=" << releaseStats.droppedReleases
+ 
+                   << ", max backlog=" << releaseStats.maxBacklog << ")\n";
+ 
+         if (execStats.overrunLateness.count > 0) {
+ 
+             std::cout << "  Overrun Lateness (us):"
+ 
+                       << " min=" << us(execStats.overrunLateness.min)
+ 
+                       << " max=" << us(execStats.overrunLateness.max)
+ 
+                       << " avg=" << us(execStats.overrunLateness.avg())
+ 
+                       << " (based on " << execStats.overrunLateness.count << " jobs)\n";
+ 
+         }
+ 
+         if (_budgetTimerArmed) {
+ 
+             std::cout << "  CPU Budget: " << us(_options.cpuBudget.count()) << "us per release (action="
+ 
+                       << budgetActionName(_options.budgetAction) << "), " << execStats.budgetOverruns
+ 
+                       << " overruns\n";
+ 
+         }
+ 
+         if (_options.perfCounters) {
+ 
+             _printPerfStats(execStats);
+ 
+         }
+ 
+         std::cout << "  RT Init: " << initReport << "\n";
+ 
+         if (_options.policy == SCHED_DEADLINE) {
+ 
+             std::cout << "  Deadline Throttling: " << _deadlineOverruns.load()
+ 
+                       << " runtime overruns\n";
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     const std::string& getName() const {
+ 
+         return _options.name;
+ 
+     }
+ 
+ 
+ 
+     // Per-release counter deltas (ServiceOptions::perfCounters)
+ 
+     PerfStats getPerfStats() const {
+ 
+         return _perfStats.load();
+ 
+     }
+ 
+ 
+ 
+     // Source id of this service's events in the trace (TraceBuffer.hpp);
+ 
+     // the sequencer uses the service index
+ 
+     void setTraceSource(uint16_t source) {
+ 
+         _traceSource = source;
+ 
+     }
+ 
+ 
+ 
+     // For service bodies: true once the running job has used up its CPU
+ 
+     // budget under BudgetAction::Abort. Always false outside a service.
+ 
+     static bool abortRequested() {
+ 
+         const Service* service = _threadService;
+ 
+         return service != nullptr && service->_options.budgetAction == BudgetAction::Abort
+ 
+             && service->_budgetExhausted.load(std::memory_order_relaxed);
+ 
+     }
+ 
+ 
+ 
+     // For service bodies: the running job produced no new output (no new
+ 
+     // frame was ready, say), so its successors are not triggered when it
+ 
+     // completes. Applies to the current job only; no-op outside a service.
+ 
+     static void suppressSuccessors() {
+ 
+         Service* service = _threadService;
+ 
+         if (service != nullptr) {
+ 
+             service->_successorsSuppressed = true;
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Append this service's histograms as CSV rows labelled
+ 
+     // "<label>.release_latency", "<label>.response_time" and
+ 
+     // "<label>.execution_time"
+ 
+     void exportHistograms(std::ostream& out, const std::string& label) const {
+ 
+         _releaseLatencyHist.exportCsv(out, label + ".release_latency");
+ 
+         _responseTimeHist.exportCsv(out, label + ".response_time");
+ 
+         _execTimeHist.exportCsv(out, label + ".execution_time");
+ 
+     }
+ 
+ 
+ 
+ private:
+ 
+     // User-supplied service function
+ 
+     std::function<void(void)> _doService;
+ 
+ 
+ 
+     // Thread and scheduling parameters
+ 
+     std::jthread              _service;
+ 
+     std::atomic<uint32_t>     _affinity;
+ 
+     bool                      _autoAffinity;
+ 
+     std::atomic<uint32_t>     _priority;
+ 
+     std::atomic<std::chrono::nanoseconds> _period;
+ 
+ 
+ 
+     uint16_t                  _traceSource{0};
+ 
+ 
+ 
+     // Dataflow edges: successors are triggered by this service's thread.
+ 
+     // _triggerMutex serializes the predecessors releasing a triggered
+ 
+     // service (the release-side writers) and guards _lastTriggeredRelease.
+ 
+     std::vector<Service*>     _successors;
+ 
+     bool                      _successorsSuppressed{false}; // by the current job; service thread only
+ 
+     bool                      _triggered{false};
+ 
+     std::mutex                _triggerMutex;
+ 
+     std::chrono::steady_clock::time_point _lastTriggeredRelease{};
+ 
+     // Posted by stop() to end a rate-limit wait for a triggered release
+ 
+     std::counting_semaphore<> _stopWake{0};
+ 
+ 
+ 
+     // Priority and core changes waiting for the next release, -1 if none
+ 
+     std::atomic<int>          _pendingPriority{-1};
+ 
+     std::atomic<int>          _pendingAffinity{-1};
+ 
+     ServiceOptions            _options;
+ 
+ 
+ 
+     // Synchronization: one posted release per queued job, plus one from stop()
+ 
+     ReleasePrimitive          _releasePrimitive;
+ 
+     std::atomic<bool>         _runningFlag;
+ 
+ 
+ 
+     // Jobs released but not yet finished, and the policy's limit on them
+ 
+     uint32_t                  _maxOutstanding;
+ 
+     alignas(64) std::atomic<uint32_t> _outstanding{0};
+ 
+     ReleaseQueue              _releaseQueue;
+ 
+ 
+ 
+     // Timing stats. The release side is written only by the releasing
+ 
+     // thread (see release()) and the execution side only by the service
+ 
+     // thread; each lives on its own cache line so the two writers never
+ 
+     // share one.
+ 
+ 
+ 
+     alignas(64) ReleaseStats _releaseWorking;
+ 
+     SeqLock<ReleaseStats>   _releaseStats;
+ 
+ 
+ 
+     alignas(64) ExecutionStats _execWorking;
+ 
+     SeqLock<ExecutionStats> _execStats;
+ 
+ 
+ 
+     // ns histograms, written only by the service thread:
+ 
+     // intended release->start, intended release->end, start->end
+ 
+     LatencyHistogram _releaseLatencyHist;
+ 
+     LatencyHistogram _responseTimeHist;
+ 
+     LatencyHistogram _execTimeHist;
+ 
+ 
+ 
+     // Guards the cold-path init report only
+ 
+     alignas(64) std::mutex _statsMutex;
+ 
+ 
+ 
+     // Outcome of each _initializeService() step
+ 
+     std::string _initReport = "not run";
+ 
+ 
+ 
+     // SIGXCPU runtime overruns of a SCHED_DEADLINE service
+ 
+     std::atomic<uint64_t> _deadlineOverruns{0};
+ 
+     // Counter the SIGXCPU handler bumps for the thread it interrupts
+ 
+     static inline thread_local std::atomic<uint64_t>* _threadDeadlineOverruns = nullptr;
+ 
+ 
+ 
+     // Per-release CPU budget: a CLOCK_THREAD_CPUTIME_ID timer that signals
+ 
+     // this thread only, and the flag its handler raises for the current job
+ 
+     timer_t           _budgetTimer{};
+ 
+     bool              _budgetTimerArmed{false}; // created; only the service thread arms it
+ 
+     std::atomic<bool> _budgetExhausted{false};
+ 
+     // The Service whose thread this is: for the budget signal handler,
+ 
+     // abortRequested() and suppressSuccessors()
+ 
+     static inline thread_local Service* _threadService = nullptr;
+ 
+ 
+ 
+     // ServiceOptions::perfCounters: the group is opened and read by the
+ 
+     // service thread only; _perfOverhead is set before the first release
+ 
+     PerfCounterGroup        _perf;
+ 
+     PerfOverhead            _perfOverhead;
+ 
+     alignas(64) PerfStats   _perfWorking;
+ 
+     SeqLock<PerfStats>      _perfStats;
+ 
+ 
+ 
+     // Counter deltas per release, the deltas of the longest job, and what
+ 
+     // reading the counters costs each release
+ 
+     void _printPerfStats(const ExecutionStats& execStats) const
+ 
+     {
+ 
+         PerfStats stats = _perfStats.load();
+ 
+         if (stats.counts[0].count == 0) {
+ 
+             std::cout << "  Perf Counters: no samples\n";
+ 
+             return;
+ 
+         }
+ 
+         std::cout << "  Perf Counters (per release, avg/max):";
+ 
+         for (size_t i = 0; i < kPerfEventCount; i++) {
+ 
+             if (_perf.isOpen(static_cast<PerfEvent>(i))) {
+ 
+                 std::cout << " " << perfEventName(static_cast<PerfEvent>(i)) << "="
+ 
+                           << static_cast<uint64_t>(stats.counts[i].avg()) << "/" << stats.counts[i].max;
+ 
+             }
+ 
+         }
+ 
+         std::cout << " (based on " << stats.counts[0].count << " samples)\n";
+ 
+         std::cout << "  Perf Counters, longest job (" << stats.worstExecNs / 1000.0 << "us, avg "
+ 
+                   << execStats.execTime.avg() / 1000.0 << "us):";
+ 
+         for (size_t i = 0; i < kPerfEventCount; i++) {
+ 
+             if (_perf.isOpen(static_cast<PerfEvent>(i))) {
+ 
+                 std::cout << " " << perfEventName(static_cast<PerfEvent>(i)) << "=" << stats.worst[i];
+ 
+             }
+ 
+         }
+ 
+         std::cout << "\n  Perf Read Overhead: " << 2.0 * _perfOverhead.readNs / 1000.0
+ 
+                   << "us per release (2 reads), included in each delta:";
+ 
+         for (size_t i = 0; i < kPerfEventCount; i++) {
+ 
+             if (_perf.isOpen(static_cast<PerfEvent>(i))) {
+ 
+                 std::cout << " " << perfEventName(static_cast<PerfEvent>(i)) << "=" << _perfOverhead.perPair[i];
+ 
+             }
+ 
+         }
+ 
+         std::cout << "\n";
+ 
+     }
+ 
+ 
+ 
+     // Most jobs the policy allows to be outstanding (running or queued)
+ 
+     static uint32_t _outstandingLimit(const ServiceOptions& options)
+ 
+     {
+ 
+         switch (options.overrunPolicy) {
+ 
+         case OverrunPolicy::Queue:
+ 
+             return std::min<uint32_t>(options.maxQueuedReleases, ReleaseQueue::kCapacity - 1) + 1;
+ 
+         case OverrunPolicy::CatchUp:
+ 
+             return ReleaseQueue::kCapacity;
+ 
+         default:
+ 
+             return 1;
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Called once by the thread on startup: apply the RT profile to the
+ 
+     // calling thread and record how each step went
+ 
+     void _initializeService()
+ 
+     {
+ 
+         if (_options.policy == SCHED_DEADLINE) {
+ 
+             _initializeDeadlineService();
+ 
+             return;
+ 
+         }
+ 
+ 
+ 
+         pthread_t threadId = pthread_self();
+ 
+ 
+ 
+         // CPU affinity; auto-affinity services stay unpinned until the
+ 
+         // sequencer partitions them
+ 
+         int affinityError = 0;
+ 
+         bool autoAffinity = _affinity == kAutoAffinity;
+ 
+         if (!autoAffinity) {
+ 
+             cpu_set_t cpuSet;
+ 
+             CPU_ZERO(&cpuSet);
+ 
+             CPU_SET(_affinity, &cpuSet);
+ 
+             affinityError = pthread_setaffinity_np(threadId, sizeof(cpuSet), &cpuSet);
+ 
+         }
+ 
+ 
+ 
+         // Scheduling policy and priority
+ 
+         struct sched_param param{};
+ 
+         param.sched_priority = static_cast<int>(_priority);
+ 
+         int policyError = pthread_setschedparam(threadId, _options.policy, &param);
+ 
+ 
+ 
+         // Lock current and future pages so nothing is paged out under us
+ 
+         int lockError = 0;
+ 
+         if (_options.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+ 
+             lockError = errno;
+ 
+         }
+ 
+ 
+ 
+         // Touch the stack we are going to need while it is still cheap
+ 
+         if (_options.prefaultStackBytes > 0) {
+ 
+             _prefaultStack(_options.prefaultStackBytes);
+ 
+         }
+ 
+ 
+ 
+         std::string report = std::string("policy=") + policyName(_options.policy)
+ 
+             + "/" + std::to_string(_priority) + " " + rtStepResult(policyError)
+ 
+             + (autoAffinity ? std::string(", affinity=auto")
+ 
+                             : ", affinity=cpu" + std::to_string(_affinity) + " " + rtStepResult(affinityError));
+ 
+         if (_options.lockMemory) {
+ 
+             report += ", mlockall " + rtStepResult(lockError);
+ 
+         }
+ 
+         if (_options.prefaultStackBytes > 0) {
+ 
+             report += ", stack prefault " + std::to_string(_options.prefaultStackBytes / 1024) + " KiB ok";
+ 
+         }
+ 
+         if (_options.cpuBudget.count() > 0) {
+ 
+             report += ", cpu budget timer " + rtStepResult(_createBudgetTimer());
+ 
+         }
+ 
+         _initializePerfCounters(report);
+ 
+ 
+ 
+         std::lock_guard<std::mutex> lock(_statsMutex);
+ 
+         _initReport = report;
+ 
+     }
+ 
+ 
+ 
+     // Open the counter group on the calling (service) thread and time its
+ 
+     // reads before the first release
+ 
+     void _initializePerfCounters(std::string& report)
+ 
+     {
+ 
+         if (!_options.perfCounters) {
+ 
+             return;
+ 
+         }
+ 
+         _perf.open();
+ 
+         report += ", perf counters: " + _perf.report();
+ 
+         _perfOverhead = _perf.measureOverhead();
+ 
+     }
+ 
+ 
+ 
+     // Create the budget timer on the calling (service) thread's CPU-time
+ 
+     // clock, delivering budgetSignal() to this thread. Returns 0 or errno.
+ 
+     int _createBudgetTimer()
+ 
+     {
+ 
+         static std::once_flag handlerOnce;
+ 
+         std::call_once(handlerOnce, []() {
+ 
+             struct sigaction action{};
+ 
+             action.sa_handler = &Service::_onBudgetExhausted;
+ 
+             sigemptyset(&action.sa_mask);
+ 
+             action.sa_flags = SA_RESTART;
+ 
+             sigaction(budgetSignal(), &action, nullptr);
+ 
+         });
+ 
+ 
+ 
+         struct sigevent event{};
+ 
+         event.sigev_notify = SIGEV_THREAD_ID;
+ 
+         event.sigev_signo = budgetSignal();
+ 
+         event._sigev_un._tid = gettid(); // glibc has no sigev_notify_thread_id name for it
+ 
+         if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &_budgetTimer) != 0) {
+ 
+             return errno;
+ 
+         }
+ 
+         _budgetTimerArmed = true;
+ 
+         return 0;
+ 
+     }
+ 
+ 
+ 
+     // Start the budget for a job: the timer expires after cpuBudget more
+ 
+     // CPU time of this thread
+ 
+     void _armBudget()
+ 
+     {
+ 
+         struct itimerspec budget{};
+ 
+         budget.it_value = toTimespec(_options.cpuBudget);
+ 
+         timer_settime(_budgetTimer, 0, &budget, nullptr);
+ 
+     }
+ 
+ 
+ 
+     // Stop the budget once the job returns. Returns true if it ran out, and
+ 
+     // undoes a demotion.
+ 
+     bool _disarmBudget()
+ 
+     {
+ 
+         struct itimerspec stop{};
+ 
+         timer_settime(_budgetTimer, 0, &stop, nullptr);
+ 
+         if (!_budgetExhausted.exchange(false, std::memory_order_relaxed)) {
+ 
+             return false;
+ 
+         }
+ 
+         if (_options.budgetAction == BudgetAction::Demote) {
+ 
+             struct sched_param param{};
+ 
+             param.sched_priority = static_cast<int>(_priority);
+ 
+             pthread_setschedparam(pthread_self(), _options.policy, &param);
+ 
+         }
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     // budgetSignal() handler, run on the service thread whose job ran out.
+ 
+     // Only async-signal-safe work: a lock-free flag and a raw syscall.
+ 
+     static void _onBudgetExhausted(int)
+ 
+     {
+ 
+         Service* service = _threadService;
+ 
+         if (service == nullptr) {
+ 
+             return;
+ 
+         }
+ 
+         service->_budgetExhausted.store(true, std::memory_order_relaxed);
+ 
+         if (service->_options.budgetAction == BudgetAction::Demote) {
+ 
+             // The raw syscall, not glibc's sched_setscheduler(), which
+ 
+             // POSIX does not list as async-signal-safe. Thread id 0 is the
+ 
+             // calling thread.
+ 
+             struct sched_param param{};
+ 
+             syscall(SYS_sched_setscheduler, 0, SCHED_IDLE, &param);
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // SCHED_DEADLINE variant of _initializeService(). The kernel refuses a
+ 
+     // deadline reservation for a thread pinned to a subset of its root
+ 
+     // domain, so _affinity is not applied; priority does not apply either.
+ 
+     void _initializeDeadlineService()
+ 
+     {
+ 
+         using std::chrono::nanoseconds;
+ 
+ 
+ 
+         // Runtime overruns are reported with SIGXCPU. The signal is sent to
+ 
+         // the thread group, but the kernel delivers it to the overrunning
+ 
+         // thread, which is the one running when the budget runs out.
+ 
+         static std::once_flag handlerOnce;
+ 
+         std::call_once(handlerOnce, []() {
+ 
+             struct sigaction action{};
+ 
+             action.sa_handler = &Service::_onDeadlineOverrun;
+ 
+             sigemptyset(&action.sa_mask);
+ 
+             action.sa_flags = SA_RESTART;
+ 
+             sigaction(SIGXCPU, &action, nullptr);
+ 
+         });
+ 
+         _threadDeadlineOverruns = &_deadlineOverruns;
+ 
+ 
+ 
+         int lockError = 0;
+ 
+         if (_options.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+ 
+             lockError = errno;
+ 
+         }
+ 
+         if (_options.prefaultStackBytes > 0) {
+ 
+             _prefaultStack(_options.prefaultStackBytes);
+ 
+         }
+ 
+ 
+ 
+         nanoseconds period   = getPeriod();
+ 
+         nanoseconds deadline = _options.deadlineDeadline.count() > 0 ? _options.deadlineDeadline : period;
+ 
+         int admissionError = setSchedDeadline(_options.deadlineRuntime, deadline, period,
+ 
+                                               kSchedFlagDlOverrun);
+ 
+ 
+ 
+         auto us = [](nanoseconds ns) { return std::to_string(ns.count() / 1000); };
+ 
+         std::string report = std::string("policy=SCHED_DEADLINE runtime=") + us(_options.deadlineRuntime)
+ 
+             + "us deadline=" + us(deadline) + "us period=" + us(period) + "us, admission "
+ 
+             + (admissionError == 0 ? std::string("accepted")
+ 
+                                    : admissionError == EBUSY ? std::string("REJECTED (bandwidth exceeded)")
+ 
+                                                              : rtStepResult(admissionError))
+ 
+             + ", affinity=root domain";
+ 
+         if (_options.lockMemory) {
+ 
+             report += ", mlockall " + rtStepResult(lockError);
+ 
+         }
+ 
+         if (_options.prefaultStackBytes > 0) {
+ 
+             report += ", stack prefault " + std::to_string(_options.prefaultStackBytes / 1024) + " KiB ok";
+ 
+         }
+ 
+         _initializePerfCounters(report);
+ 
+ 
+ 
+         std::lock_guard<std::mutex> lock(_statsMutex);
+ 
+         _initReport = report;
+ 
+     }
+ 
+ 
+ 
+     static void _onDeadlineOverrun(int)
+ 
+     {
+ 
+         if (_threadDeadlineOverruns != nullptr) {
+ 
+             _threadDeadlineOverruns->fetch_add(1, std::memory_order_relaxed);
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Grow the stack by bytes and write every page, so the pages are mapped
+ 
+     // (and locked by MCL_FUTURE) before the first release
+ 
+     __attribute__((noinline)) static void _prefaultStack(size_t bytes)
+ 
+     {
+ 
+         volatile unsigned char* stack = static_cast<unsigned char*>(alloca(bytes));
+ 
+         for (size_t offset = 0; offset < bytes; offset += 4096) {
+ 
+             stack[offset] = 0;
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Apply requestPriority()/requestAffinity() to the calling (service)
+ 
+     // thread between jobs
+ 
+     void _applyPendingChanges()
+ 
+     {
+ 
+         int priority = _pendingPriority.exchange(-1, std::memory_order_acquire);
+ 
+         if (priority >= 0 && _options.policy != SCHED_DEADLINE) {
+ 
+             struct sched_param param{};
+ 
+             param.sched_priority = priority;
+ 
+             int error = pthread_setschedparam(pthread_self(), _options.policy, &param);
+ 
+             if (error == 0) {
+ 
+                 _priority = static_cast<uint32_t>(priority);
+ 
+             } else {
+ 
+                 std::cerr << "Service " << _options.name << ": priority " << priority << " " << rtStepResult(error) << "\n";
+ 
+             }
+ 
+         }
+ 
+ 
+ 
+         int core = _pendingAffinity.exchange(-1, std::memory_order_acquire);
+ 
+         if (core >= 0 && _options.policy != SCHED_DEADLINE) {
+ 
+             cpu_set_t cpuSet;
+ 
+             CPU_ZERO(&cpuSet);
+ 
+             CPU_SET(core, &cpuSet);
+ 
+             int error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+ 
+             if (error == 0) {
+ 
+                 _affinity = static_cast<uint32_t>(core);
+ 
+             } else {
+ 
+                 std::cerr << "Service " << _options.name << ": affinity cpu" << core << " " << rtStepResult(error) << "\n";
+ 
+             }
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Main loop for the service thread
+ 
+     void _provideService()
+ 
+     {
+ 
+         _threadService = this; // for the static helpers service bodies call
+ 
+         _initializeService();
+ 
+         // Whether or not tracing is on yet: the ring is allocated here, so
+ 
+         // no event this thread emits ever takes the lazy allocation path
+ 
+         Tracer::instance().registerThread();
+ 
+         while (_runningFlag)
+ 
+         {
+ 
+             // Wait until the service is released
+ 
+             _releasePrimitive.wait();
+ 
+             if (!_runningFlag) {
+ 
+                 break; // check again in case we were stopped
+ 
+             }
+ 
+             _applyPendingChanges();
+ 
+ 
+ 
+             // Capture start time
+ 
+             auto startTime = std::chrono::steady_clock::now();
+ 
+ 
+ 
+             // Take this job's release instants for jitter measurement
+ 
+             ReleaseQueue::Entry job;
+ 
+             if (!_releaseQueue.pop(job)) {
+ 
+                 continue; // a stop() wakeup, not a release
+ 
+             }
+ 
+             std::chrono::steady_clock::time_point localReleaseTime{
+ 
+                 std::chrono::steady_clock::duration(job.releasedNs)
+ 
+             };
+ 
+             std::chrono::steady_clock::time_point localIntendedTime{
+ 
+                 std::chrono::steady_clock::duration(job.intendedNs)
+ 
+             };
+ 
+             // A rate-limited trigger() is released ahead of its instant;
+ 
+             // wait for it, but let stop() end the wait
+ 
+             if (localIntendedTime > startTime) {
+ 
+                 if (_stopWake.try_acquire_until(localIntendedTime) || !_runningFlag) {
+ 
+                     break;
+ 
+                 }
+ 
+                 startTime = std::chrono::steady_clock::now();
+ 
+             }
+ 
+ 
+ 
+             // Calculate start-time jitter
+ 
+             auto startJitterNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+ 
+                 startTime - localReleaseTime
+ 
+             ).count();
+ 
+ 
+ 
+             // Run the user-provided service function, under its CPU budget
+ 
+             Tracer::instance().emitAt(TraceEventType::Start, _traceSource, startTime.time_since_epoch().count(),
+ 
+                                       job.intendedNs);
+ 
+             if (_budgetTimerArmed) {
+ 
+                 _armBudget();
+ 
+             }
+ 
+             PerfSample perfBefore;
+ 
+             PerfSample perfAfter;
+ 
+             bool counted = _perf.read(perfBefore);
+ 
+             _successorsSuppressed = false;
+ 
+             _doService();
+ 
+             counted = counted && _perf.read(perfAfter);
+ 
+             bool budgetExhausted = _budgetTimerArmed && _disarmBudget();
+ 
+ 
+ 
+             // Capture end time
+ 
+             auto endTime = std::chrono::steady_clock::now();
+ 
+             Tracer::instance().emitAt(TraceEventType::End, _traceSource, endTime.time_since_epoch().count(),
+ 
+                                       job.intendedNs);
+ 
+             auto execTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+ 
+                 endTime - startTime
+ 
+             ).count();
+ 
+ 
+ 
+             // The job is done; the next release is no longer an overrun
+ 
+             _outstanding.fetch_sub(1, std::memory_order_release);
+ 
+ 
+ 
+             // Its output is ready: release the dataflow successors now,
+ 
+             // unless the job reported it had none
+ 
+             if (!_successorsSuppressed) {
+ 
+                 for (Service* successor : _successors) {
+ 
+                     successor->trigger(endTime);
+ 
+                 }
+ 
+             }
+ 
+ 
+ 
+             // Finishing after the next release instant is an overrun of
+ 
+             // the implicit deadline (= period)
+ 
+             auto overrunNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+ 
+                 endTime - (localIntendedTime + getPeriod())
+ 
+             ).count();
+ 
+ 
+ 
+             // Update stats and publish a snapshot for printStats()
+ 
+             _execWorking.startJitter.add(startJitterNs);
+ 
+             _execWorking.execTime.add(execTimeNs);
+ 
+             if (overrunNs > 0) {
+ 
+                 _execWorking.overrunLateness.add(overrunNs);
+ 
+             }
+ 
+             if (budgetExhausted) {
+ 
+                 _execWorking.budgetOverruns++;
+ 
+             }
+ 
+             _execStats.store(_execWorking);
+ 
+             if (counted) {
+ 
+                 _perfWorking.add(perfAfter - perfBefore, execTimeNs);
+ 
+                 _perfStats.store(_perfWorking);
+ 
+             }
+ 
+             if (budgetExhausted && _options.budgetAction == BudgetAction::Log) {
+ 
+                 std::cerr << "Service " << (_options.name.empty() ? "(unnamed)" : _options.name)
+ 
+                           << ": job exceeded its " << _options.cpuBudget.count() / 1000 << "us CPU budget ("
+ 
+                           << execTimeNs / 1000 << "us wall clock)\n";
+ 
+             }
+ 
+ 
+ 
+             _releaseLatencyHist.recordSigned((startTime - localIntendedTime).count());
+ 
+             _responseTimeHist.recordSigned((endTime - localIntendedTime).count());
+ 
+             _execTimeHist.recordSigned(execTimeNs);
+ 
+         }
+ 
+     }
+ 
+ };
+ 
+ 
+ 
+ // The sequencer class contains the services set and manages
+ 
+ // starting/stopping the services. While the services are running,
+ 
+ // the sequencer releases each service at the requisite timepoint.
+ 
+ class Sequencer
+ 
+ {
+ 
+ public:
+ 
+     // Add a service; warns on stderr if the completion test says its core
+ 
+     // can no longer meet every deadline (for a kAutoAffinity service: if no
+ 
+     // core could take it), but adds it anyway. A kAutoAffinity service is
+ 
+     // left unpinned for partitionServices().
+ 
+     template<typename... Args>
+ 
+     void addService(Args&&... args)
+ 
+     {
+ 
+         // Construct a Service in-place and store it
+ 
+         auto service = std::make_unique<Service>(std::forward<Args>(args)...);
+ 
+         std::lock_guard<std::mutex> lock(_addMutex);
+ 
+         std::string verdict;
+ 
+         int core = -1;
+ 
+         if (!_admit(service->getTaskModel(), service->getPolicy(), service->getAffinity(), core, verdict)) {
+ 
+             std::cerr << "Sequencer: adding " << _label(*service, _serviceCount())
+ 
+                       << " makes the service set infeasible: " << verdict << "\n";
+ 
+         }
+ 
+         _insertService(std::move(service));
+ 
+     }
+ 
+ 
+ 
+     // Add a service only if the completion test still passes on its core
+ 
+     // with it; a kAutoAffinity service is placed on the first core that
+ 
+     // passes. Returns false (and adds nothing) otherwise. The test runs on
+ 
+     // the task model the arguments describe (period, options.wcet,
+ 
+     // priority), so a rejected service never gets a thread. Safe to call
+ 
+     // while the services are running: the scheduler is woken, the new
+ 
+     // service joins the running release grid and no other service loses
+ 
+     // its phase. The arguments are those of the Service constructors.
+ 
+     template<typename T, typename P>
+ 
+     bool tryAddService(T&& doService, uint8_t affinity, uint8_t priority, P period,
+ 
+                        ServiceOptions options = {})
+ 
+     {
+ 
+         TaskModel candidate{_periodOf(period), options.wcet, std::chrono::nanoseconds{0}, priority};
+ 
+         std::lock_guard<std::mutex> lock(_addMutex);
+ 
+         std::string verdict;
+ 
+         int core = -1;
+ 
+         if (!_admit(candidate, options.policy, affinity, core, verdict)) {
+ 
+             std::cerr << "Sequencer: rejected " << _label(options.name, _serviceCount()) << ": " << verdict << "\n";
+ 
+             return false;
+ 
+         }
+ 
+         auto service = std::make_unique<Service>(std::forward<T>(doService), affinity, priority, period,
+ 
+                                                  std::move(options));
+ 
+         if (affinity == kAutoAffinity && core >= 0) {
+ 
+             service->setAffinity(static_cast<uint8_t>(core));
+ 
+         }
+ 
+         _insertService(std::move(service));
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     // How the scheduler thread waits for the next release
+ 
+     enum class ReleaseBackend
+ 
+     {
+ 
+         AbsoluteSleep, // clock_nanosleep(TIMER_ABSTIME) until the earliest release
+ 
+         TimerFd        // one periodic timerfd per service, multiplexed with epoll
+ 
+     };
+ 
+ 
+ 
+     // Select the release backend; must be called before startServices()
+ 
+     void setReleaseBackend(ReleaseBackend backend)
+ 
+     {
+ 
+         _backend = backend;
+ 
+     }
+ 
+ 
+ 
+     ~Sequencer()
+ 
+     {
+ 
+         _runningFlag = false;
+ 
+         _wakeScheduler();
+ 
+         // Join the scheduler before the services it releases are destroyed
+ 
+         if (_schedulerThread.joinable()) {
+ 
+             _schedulerThread.join();
+ 
+         }
+ 
+         if (_wakeFd >= 0) {
+ 
+             close(_wakeFd);
+ 
+         }
+ 
+     }
+ 
+ 
+ 
+     // Core the scheduler thread is pinned to; it always runs SCHED_FIFO at
+ 
+     // the highest priority so releases are never delayed by the services
+ 
+     void setSchedulerAffinity(uint8_t core)
+ 
+     {
+ 
+         _schedulerAffinity = core;
+ 
+     }
+ 
+ 
+ 
+     // The scheduler thread measures its own wakeup latency (actual minus
+ 
+     // intended wakeup, as cyclictest does) in either backend: AbsoluteSleep
+ 
+     // takes one sample per wakeup against the instant it slept until,
+ 
+     // TimerFd one per timer expiration against that expiration's due
+ 
+     // time, so expirations missed between two wakeups count as late
+ 
+     // wakeups too. Wakeups later than threshold are counted separately.
+ 
+     void setWakeupLatencyThreshold(std::chrono::nanoseconds threshold)
+ 
+     {
+ 
+         _wakeupThresholdNs = threshold.count();
+ 
+     }
+ 
+ 
+ 
+     const LatencyHistogram& getWakeupLatency() const
+ 
+     {
+ 
+         return _wakeupLatencyHist;
+ 
+     }
+ 
+ 
+ 
+     uint64_t getLateWakeups() const
+ 
+     {
+ 
+         return _lateWakeups.load(std::memory_order_relaxed);
+ 
+     }
+ 
+ 
+ 
+     void startServices()
+ 
+     {
+ 
+         // A stopped scheduler was woken and is exiting; let it go before
+ 
+         // the new one takes over the service list
+ 
+         if (_schedulerThread.joinable()) {
+ 
+             _schedulerThread.join();
+ 
+         }
+ 
+         {
+ 
+             std::lock_guard<std::mutex> lock(_pendingMutex);
+ 
+             _pendingServices = _snapshot();
+ 
+             _servicesPending = true;
+ 
+         }
+ 
+         _runningFlag = true;
+ 
+         if (_backend == ReleaseBackend::TimerFd && _wakeFd < 0) {
+ 
+             _wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+ 
+         }
+ 
+         // Start a scheduler thread that periodically releases each service
+ 
+         _schedulerThread = std::jthread([this]()
+ 
+         {
+ 
+             _initializeScheduler();
+ 
+             if (_backend == ReleaseBackend::TimerFd) {
+ 
+                 _timerFdReleaseLoop();
+ 
+             } else {
+ 
+                 _absoluteSleepReleaseLoop();
+ 
+             }
+ 
+         });
+ 
+     }
+ 
+ 
+ 
+     void stopServices()
+ 
+     {
+ 
+         // Signal the scheduler to stop
+ 
+         _runningFlag = false;
+ 
+         _wakeScheduler();
+ 
+ 
+ 
+         // Stop each service, then wait for every service thread: a job
+ 
+         // finishing late may still trigger() a successor, so no service
+ 
+         // may be destroyed while any of them runs
+ 
+         auto services = _snapshot();
+ 
+         for (Service* service : services)
+ 
+         {
+ 
+             service->stop();
+ 
+         }
+ 
+         for (Service* service : services)
+ 
+         {
+ 
+             service->join();
+ 
+         }
+ 
+ 
+ 
+         {
+ 
+             std::lock_guard<std::mutex> lock(_reportMutex);
+ 
+             std::cout << "Sequencer thread: " << _schedulerInitReport << "\n";
+ 
+         }
+ 
+         // Scheduler lateness shows up in every service's release latency;
+ 
+         // compare the two to tell sequencer jitter from service jitter
+ 
+         std::cout << "  Wakeup Latency (us): " << _wakeupLatencyHist.summary() << "\n";
+ 
+         std::cout << "  Late Wakeups: " << _lateWakeups.load() << " over "
+ 
+                   << static_cast<double>(_wakeupThresholdNs.load()) / 1000.0 << "us\n";
+ 
+ 
+ 
+         // Now print out each service's collected stats
+ 
+         for (Service* service : services)
+ 
+         {
+ 
+             service->printStats();
+ 
+         }
+ 
+ 
+ 
+         // Shared state the services lock (every live RtMutex)
+ 
+         RtMutex::forEach([](const RtMutex& mutex) { mutex.printStats(std::cout); });
+ 
+     }
+ 
+ 
+ 
+     // Dataflow (DAG) triggering: every completed job of service from
+ 
+     // releases service to immediately, instead of it waiting for its next
+ 
+     // grid point; a job with no output calls Service::suppressSuccessors()
+ 
+     // to release nothing. to keeps its own priority and core; its period becomes
+ 
+     // the minimum time between two of its releases (see
+ 
+     // Service::trigger()), so the feasibility tests and partitioning
+ 
+     // still apply to it. A service with any incoming edge is no longer
+ 
+     // released periodically. Call before startServices(). Returns false
+ 
+     // (and adds nothing) for an unknown service, a self edge, an edge that
+ 
+     // would close a cycle, or while the services are running.
+ 
+     bool addPrecedence(size_t from, size_t to)
+ 
+     {
+ 
+         Service* source = _find(from);
+ 
+         Service* target = _find(to);
+ 
+         if (source == nullptr || target == nullptr || from == to) {
+ 
+             std::cerr << "Sequencer: invalid precedence edge " << from << " -> " << to << "\n";
+ 
+             return false;
+ 
+         }
+ 
+         if (_schedulerThread.joinable()) {
+ 
+             std::cerr << "Sequencer: precedence edges must be added before startServices()\n";
+ 
+             return false;
+ 
+         }
+ 
+         if (_reaches(target, source)) {
+ 
+             std::cerr << "Sequencer: " << _label(*source, from) << " -> "
+ 
+                       << _label(*target, to) << " would close a cycle\n";
+ 
+             return false;
+ 
+         }
+ 
+         source->addSuccessor(target);
+ 
+         target->setTriggered(true);
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     // Index of the service named name (ServiceOptions::name), if any
+ 
+     std::optional<size_t> findService(const std::string& name) const
+ 
+     {
+ 
+         std::lock_guard<std::mutex> lock(_servicesMutex);
+ 
+         for (size_t i = 0; i < _services.size(); i++)
+ 
+         {
+ 
+             if (_services[i]->getName() == name) {
+ 
+                 return i;
+ 
+             }
+ 
+         }
+ 
+         return std::nullopt;
+ 
+     }
+ 
+ 
+ 
+     // Live reconfiguration, applied at each service's next release without
+ 
+     // stopping any thread: the period by the scheduler as it advances the
+ 
+     // service's release grid, priority and core by the service thread
+ 
+     // before it starts the job. Safe to call from any thread, including a
+ 
+     // service. Return false for an unknown id or a value that does not
+ 
+     // apply (a non-positive period; SCHED_DEADLINE services keep their
+ 
+     // reservation and root-domain placement).
+ 
+     bool setPeriod(size_t id, std::chrono::nanoseconds period)
+ 
+     {
+ 
+         Service* service = _find(id);
+ 
+         if (service == nullptr || period.count() <= 0 || service->getPolicy() == SCHED_DEADLINE) {
+ 
+             return false;
+ 
+         }
+ 
+         service->setPeriod(period);
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     bool setPriority(size_t id, uint8_t priority)
+ 
+     {
+ 
+         Service* service = _find(id);
+ 
+         if (service == nullptr || service->getPolicy() == SCHED_DEADLINE
+ 
+             || priority < sched_get_priority_min(service->getPolicy())
+ 
+             || priority > sched_get_priority_max(service->getPolicy())) {
+ 
+             return false;
+ 
+         }
+ 
+         service->requestPriority(priority);
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     bool setAffinity(size_t id, uint8_t core)
+ 
+     {
+ 
+         Service* service = _find(id);
+ 
+         if (service == nullptr || service->getPolicy() == SCHED_DEADLINE
+ 
+             || core >= std::max(1u, std::thread::hardware_concurrency())) {
+ 
+             return false;
+ 
+         }
+ 
+         service->requestAffinity(core);
+ 
+         return true;
+ 
+     }
+ 
+ 
+ 
+     // Result of assignPipelinePhases()
+ 
+     struct PipelinePlan
+ 
+     {
+ 
+         std::vector<std::chrono::nanoseconds> phases;    // per chain stage
+ 
+         std::chrono::nanoseconds worstCaseLatency{0};    // with the new phases
+ 
+         std::chrono::nanoseconds zeroPhaseLatency{0};    // with every phase zero
+ 
+     };
+ 
+ 
+ 
+     // Phase a chain of services (indices in data-flow order, e.g. camera,
+ 
+     // detect, decide, motor) so each stage is released just as its
+ 
+     // upstream stage is known to have finished: phase[i] = phase[i-1] +
+ 
+     // worst measured response time of stage i-1 (release latency,
+ 
+     // preemption and execution included). Needs the services to have run
+ 
+     // for a while first. If the sequencer is running, only the scheduler
+ 
+     // thread is restarted so the new grid takes effect; services keep
+ 
+     // running. Reports the worst-case end-to-end latency (head release ->
+ 
+     // tail completion) against the all-zero-phase schedule.
+ 
+     PipelinePlan assignPipelinePhases(const std::vector<size_t>& chain)
+ 
+     {
+ 
+         using std::chrono::nanoseconds;
+ 
+ 
+ 
+         PipelinePlan plan;
+ 
+         std::vector<Service*> stages;
+ 
+         std::vector<nanoseconds> periods;
+ 
+         std::vector<nanoseconds> responses;
+ 
+         for (size_t index : chain)
+ 
+         {
+ 
+             Service* stage = _find(index);
+ 
+             if (stage == nullptr || stage->getPeriod().count() <= 0) {
+ 
+                 std::cerr << "Sequencer: pipeline stage " << index << " is not a periodic service\n";
+ 
+                 return plan;
+ 
+             }
+ 
+             stages.push_back(stage);
+ 
+             periods.push_back(stage->getPeriod());
+ 
+             responses.push_back(stage->getWorstResponseTime());
+ 
+             if (responses.back().count() == 0) {
+ 
+                 std::cerr << "Sequencer: pipeline stage " << index
+ 
+                           << " has no measurements yet; its phase assumes zero response time\n";
+ 
+             }
+ 
+         }
+ 
+ 
+ 
+         nanoseconds offset{0};
+ 
+         for (size_t i = 0; i < chain.size(); i++)
+ 
+         {
+ 
+             plan.phases.push_back(offset % periods[i]);
+ 
+             offset += responses[i];
+ 
+         }
+ 
+         plan.worstCaseLatency = _pipelineLatency(periods, plan.phases, responses);
+ 
+         plan.zeroPhaseLatency = _pipelineLatency(periods, std::vector<nanoseconds>(chain.size()), responses);
+ 
+ 
+ 
+         // Apply the phases; the scheduler thread reads them only when it
+ 
+         // lays out its release grid, so restart it around the update
+ 
+         bool wasRunning = _schedulerThread.joinable();
+ 
+         if (wasRunning) {
+ 
+             _runningFlag = false;
+ 
+             _wakeScheduler();
+ 
+             _schedulerThread.join();
+ 
+         }
+ 
+         for (size_t i = 0; i < chain.size(); i++)
+ 
+         {
+ 
+             stages[i]->setPhase(plan.phases[i]);
+ 
+         }
+ 
+         if (wasRunning) {
+ 
+             startServices();
+ 
+         }
+ 
+ 
+ 
+         auto ms = [](nanoseconds ns) { return static_cast<double>(ns.count()) / 1e6; };
+ 
+         std::cout << "Pipeline phases:\n";
+ 
+         for (size_t i = 0; i < chain.size(); i++)
+ 
+         {
+ 
+             const auto& name = stages[i]->getName();
+ 
+             std::cout << "  " << (name.empty() ? "service" + std::to_string(chain[i]) : name)
+ 
+                       << ": period=" << ms(periods[i]) << "ms worst response=" << ms(responses[i])
+ 
+                       << "ms phase=" << ms(plan.phases[i]) << "ms\n";
+ 
+         }
+ 
+         std::cout << "  Worst-case end-to-end latency: " << ms(plan.worstCaseLatency)
+ 
+                   << "ms (all-zero phases: " << ms(plan.zeroPhaseLatency) << "ms)\n";
+ 
+         return plan;
+ 
+     }
+ 
+ 
+ 
+     // Assign every kAutoAffinity service to a core: decreasing utilization,
+ 
+     // first-fit or best-fit, with the completion test (response-time
+ 
+     // analysis) deciding whether a core can take a service. Execution
+ 
+     // times are the declared WCETs or the worst measured so far, so let
+ 
+     // the services run for a while first. Pinned services count as load on their core;
+ 
+     // SCHED_DEADLINE services are left to the kernel. A service no core
+ 
+     // can take goes to the least utilized core and the result is marked
+ 
+     // infeasible. cores == 0 means every online CPU. Calling it again
+ 
+     // re-places the kAutoAffinity services with the latest measurements.
+ 
+     PartitionResult partitionServices(PartitionHeuristic heuristic = PartitionHeuristic::FirstFitDecreasing,
+ 
+                                       size_t cores = 0)
+ 
+     {
+ 
+         if (cores == 0) {
+ 
+             cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+ 
+         }
+ 
+ 
+ 
+         std::vector<TaskModel> tasks;
+ 
+         std::vector<int> preplaced;
+ 
+         std::vector<size_t> serviceIndex;
+ 
+         auto services = _snapshot();
+ 
+         for (size_t i = 0; i < services.size(); i++)
+ 
+         {
+ 
+             const auto& service = *services[i];
+ 
+             if (service.getPolicy() == SCHED_DEADLINE || service.getPeriod().count() <= 0) {
+ 
+                 continue;
+ 
+             }
+ 
+             tasks.push_back(service.getTaskModel());
+ 
+             preplaced.push_back(service.isAutoAffinity() ? -1 : service.getAffinity());
+ 
+             serviceIndex.push_back(i);
+ 
+         }
+ 
+ 
+ 
+         PartitionResult result = partition(tasks, preplaced, cores, heuristic);
+ 
+ 
+ 
+         std::cout << "Partition (" << (heuristic == PartitionHeuristic::FirstFitDecreasing ? "first" : "best")
+ 
+                   << "-fit decreasing, " << cores << " cores):\n";
+ 
+         for (size_t t = 0; t < tasks.size(); t++)
+ 
+         {
+ 
+             auto& service = *services[serviceIndex[t]];
+ 
+             const auto& name = service.getName();
+ 
+             bool automatic = preplaced[t] < 0;
+ 
+             int core = result.core[t];
+ 
+             bool unplaced = automatic && core < 0;
+ 
+             if (unplaced) {
+ 
+                 core = static_cast<int>(std::min_element(result.utilization.begin(), result.utilization.end())
+ 
+                                         - result.utilization.begin());
+ 
+                 result.core[t] = core;
+ 
+                 result.utilization[core] += tasks[t].utilization();
+ 
+             }
+ 
+             int error = automatic ? service.setAffinity(static_cast<uint8_t>(core)) : 0;
+ 
+             std::cout << "  " << (name.empty() ? "service" + std::to_string(serviceIndex[t]) : name)
+ 
+                       << ": U=" << tasks[t].utilization() << " -> cpu" << core
+ 
+                       << (automatic ? (error == 0 ? " (assigned)" : " (assign " + rtStepResult(error) + ")")
+ 
+                           : static_cast<size_t>(core) < cores ? std::string(" (pinned)")
+ 
+                                                               : " (pinned outside the " + std::to_string(cores)
+ 
+                                                                     + " cores analysed, not tested)")
+ 
+                       << (unplaced ? " OVERLOADED: no core passes the response-time test" : "")
+ 
+                       << "\n";
+ 
+         }
+ 
+         for (size_t c = 0; c < cores; c++)
+ 
+         {
+ 
+             std::cout << "  cpu" << c << " utilization=" << result.utilization[c] << "\n";
+ 
+         }
+ 
+         std::cout << "  Response-time test: " << (result.feasible ? "feasible" : "NOT feasible") << "\n";
+ 
+         return result;
+ 
+     }
+ 
+ 
+ 
+     // Write every service's histograms, and the wait/hold histograms of
+ 
+     // every RtMutex, to path in the CSV format hist.py reads. Returns false
+ 
+     // if the file cannot be written.
+ 
+     bool exportHistograms(const std::string& path) const
+ 
+     {
+ 
+         std::ofstream out(path);
+ 
+         if (!out) {
+ 
+             std::cerr << "Sequencer: cannot write " << path << "\n";
+ 
+             return false;
+ 
+         }
+ 
+         out << LatencyHistogram::kCsvHeader << "\n";
+ 
+         _wakeupLatencyHist.exportCsv(out, "sequencer.wakeup_latency");
+ 
+         auto services = _snapshot();
+ 
+         for (size_t i = 0; i < services.size(); i++)
+ 
+         {
+ 
+             services[i]->exportHistograms(out, _label(*services[i], i));
+ 
+         }
+ 
+         RtMutex::forEach([&out](const RtMutex& mutex) { mutex.exportHistograms(out); });
+ 
+         return static_cast<bool>(out);
+ 
+     }
+ 
+ 
+ 
+ private:
+ 
+     // Polling-free release loop: every service is released on its own
+ 
+     // absolute grid start + k*period, so a late wakeup never pushes later
+ 
+     // releases back and lateness cannot accumulate into drift.
+ 
+     void _absoluteSleepReleaseLoop()
+ 
+     {
+ 
+         using std::chrono::steady_clock;
+ 
+ 
+ 
+         // The services this thread releases, in the order they were
+ 
+         // handed over, and the next grid point of each
+ 
+         std::vector<Service*> scheduled;
+ 
+         std::vector<steady_clock::time_point> nextReleaseVector;
+ 
+ 
+ 
+         _sleep.bind();
+ 
+         auto startTime = steady_clock::now();
+ 
+         while (_runningFlag)
+ 
+         {
+ 
+             // Services added since the last wakeup join the grid;
+ 
+             // triggered services never come due on it
+ 
+             if (_adoptPendingServices(scheduled) > 0) {
+ 
+                 auto now = steady_clock::now();
+ 
+                 for (size_t i = nextReleaseVector.size(); i < scheduled.size(); i++)
+ 
+                 {
+ 
+                     nextReleaseVector.push_back(scheduled[i]->isTriggered()
+ 
+                                                     ? steady_clock::time_point::max()
+ 
+                                                     : _firstRelease(startTime, *scheduled[i], now));
+ 
+                 }
+ 
+             }
+ 
+ 
+ 
+             // Sleep until the earliest pending release (with nothing
+ 
+             // periodic yet, until woken); a stop or a new service cuts the
+ 
+             // sleep short
+ 
+             auto earliest = nextReleaseVector.empty()
+ 
+                                 ? steady_clock::time_point::max()
+ 
+                                 : *std::min_element(nextReleaseVector.begin(), nextReleaseVector.end());
+ 
+             if (!_sleep.sleepUntil(earliest)) {
+ 
+                 continue;
+ 
+             }
+ 
+             auto currentTime = steady_clock::now();
+ 
+             if (!_runningFlag) {
+ 
+                 break;
+ 
+             }
+ 
+             _recordWakeup(earliest, currentTime);
+ 
+ 
+ 
+             for (size_t i = 0; i < scheduled.size(); i++)
+ 
+             {
+ 
+                 if (nextReleaseVector[i] > currentTime) {
+ 
+                     continue;
+ 
+                 }
+ 
+ 
+ 
+                 auto& currentService = *scheduled[i];
+ 
+                 currentService.release(nextReleaseVector[i]);
+ 
+ 
+ 
+                 // Advance along the grid (with the period as of now, so a
+ 
+                 // setPeriod() takes effect from this release); if we fell
+ 
+                 // more than a period behind, skip to the first grid point
+ 
+                 // still in the future
+ 
+                 auto servicePeriod = currentService.getPeriod();
+ 
+                 nextReleaseVector[i] += servicePeriod;
+ 
+                 if (nextReleaseVector[i] <= currentTime && servicePeriod.count() > 0) {
+ 
+                     auto behind = (currentTime - nextReleaseVector[i]) / servicePeriod + 1;
+ 
+                     currentService.recordMissedReleases(nextReleaseVector[i], servicePeriod,
+ 
+                                                         static_cast<uint64_t>(behind));
+ 
+                     nextReleaseVector[i] += behind * servicePeriod;
+ 
+                 }
+ 
+             }
+ 
+         }
+ 
+         _sleep.unbind();
+ 
+     }
+ 
+ 
+ 
+     // timerfd backend: each service gets a CLOCK_MONOTONIC timerfd armed
+ 
+     // with an absolute first expiry and its period as the interval. The
+ 
+     // scheduler thread only wakes when one of them fires, and the
+ 
+     // expiration count read from the fd tells us how many periods passed.
+ 
+     void _timerFdReleaseLoop()
+ 
+     {
+ 
+         using std::chrono::steady_clock;
+ 
+         using std::chrono::nanoseconds;
+ 
+         using std::chrono::duration_cast;
+ 
+ 
+ 
+         int epollFd = epoll_create1(EPOLL_CLOEXEC);
+ 
+         if (epollFd < 0) {
+ 
+             std::cerr << "Sequencer: epoll_create1 failed: " << strerror(errno) << "\n";
+ 
+             return;
+ 
+         }
+ 
+         if (_wakeFd >= 0) {
+ 
+             struct epoll_event ev{};
+ 
+             ev.events   = EPOLLIN;
+ 
+             ev.data.u64 = std::numeric_limits<uint64_t>::max();
+ 
+             epoll_ctl(epollFd, EPOLL_CTL_ADD, _wakeFd, &ev);
+ 
+         }
+ 
+ 
+ 
+         // The services this thread releases, in the order they were handed
+ 
+         // over, with the timerfd of each, its next expiry and the interval
+ 
+         // it is armed with (re-armed when setPeriod() changes it)
+ 
+         std::vector<Service*> scheduled;
+ 
+         std::vector<int> timerFds;
+ 
+         std::vector<steady_clock::time_point> nextReleaseVector;
+ 
+         std::vector<nanoseconds> armedPeriods;
+ 
+         std::vector<struct epoll_event> events(1);
+ 
+ 
+ 
+         auto startTime = steady_clock::now();
+ 
+         while (_runningFlag)
+ 
+         {
+ 
+             // Services added since the last wakeup get a timer on the grid
+ 
+             // of startTime; triggered ones are released by their
+ 
+             // predecessors and get none
+ 
+             if (_adoptPendingServices(scheduled) > 0) {
+ 
+                 auto now = steady_clock::now();
+ 
+                 for (size_t i = timerFds.size(); i < scheduled.size(); i++)
+ 
+                 {
+ 
+                     timerFds.push_back(-1);
+ 
+                     nextReleaseVector.push_back(steady_clock::time_point::max());
+ 
+                     armedPeriods.push_back(scheduled[i]->getPeriod());
+ 
+                     if (scheduled[i]->isTriggered()) {
+ 
+                         continue;
+ 
+                     }
+ 
+                     nextReleaseVector[i] = _firstRelease(startTime, *scheduled[i], now);
+ 
+ 
+ 
+                     timerFds[i] = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+ 
+                     if (timerFds[i] < 0) {
+ 
+                         std::cerr << "Sequencer: timerfd_create failed: " << strerror(errno) << "\n";
+ 
+                         continue;
+ 
+                     }
+ 
+ 
+ 
+                     struct itimerspec its{};
+ 
+                     its.it_value    = toTimespec(duration_cast<nanoseconds>(nextReleaseVector[i].time_since_epoch()));
+ 
+                     its.it_interval = toTimespec(duration_cast<nanoseconds>(armedPeriods[i]));
+ 
+                     if (timerfd_settime(timerFds[i], TFD_TIMER_ABSTIME, &its, nullptr) < 0) {
+ 
+                         std::cerr << "Sequencer: timerfd_settime failed: " << strerror(errno) << "\n";
+ 
+                     }
+ 
+ 
+ 
+                     struct epoll_event ev{};
+ 
+                     ev.events   = EPOLLIN;
+ 
+                     ev.data.u64 = i;
+ 
+                     epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFds[i], &ev);
+ 
+                 }
+ 
+                 events.resize(scheduled.size() + 1);
+ 
+             }
+ 
  
- public:
  
-     template<typename T>
+             int ready = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
  
-     Service(T&& doService, uint8_t affinity, uint8_t priority, uint32_t period)
+             if (ready < 0) {
  
-       : _doService(doService),
+                 if (errno == EINTR) {
  
-         _affinity(affinity),
+                     continue;
  
-         _priority(priority),
+                 }
  
-         _period(period),
+                 std::cerr << "Sequencer: epoll_wait failed: " << strerror(errno) << "\n";
  
-         _releaseSemaphore(0), // Initialize release semaphore
+                 break;
  
-         _runningFlag(true)
+             }
  
-     {
+             auto wakeTime = steady_clock::now();
  
-         // Start the service thread, which will run _provideService()
  
-         _service = std::jthread(&Service::_provideService, this);
  
-     }
+             for (int e = 0; e < ready && _runningFlag; e++)
  
+             {
  
+                 uint64_t index = events[e].data.u64;
  
-     void stop(){
+                 if (index >= scheduled.size()) {
  
-         // Signal the thread to stop
+                     // Stop or add request on the wake eventfd; drain it so
  
-         _runningFlag = false;
+                     // the next epoll_wait does not see it again
  
-         // Release the semaphore in case the thread is waiting
+                     uint64_t wakeups = 0;
  
-         _releaseSemaphore.release();
+                     if (read(_wakeFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
  
-     }
+                         std::cerr << "Sequencer: failed to drain wake eventfd: " << strerror(errno) << "\n";
  
+                     }
  
+                     continue;
  
-     void release(){
+                 }
  
-         // Record the release time for jitter calculations
  
-         {
  
-             std::lock_guard<std::mutex> lock(_statsMutex);
+                 uint64_t expirations = 0;
  
-             _releaseTime = std::chrono::steady_clock::now();
+                 if (read(timerFds[index], &expirations, sizeof(expirations)) != sizeof(expirations)
  
-         }
+                     || expirations == 0) {
  
-         // Release the service using the semaphore
+                     continue;
  
-         _releaseSemaphore.release();
+                 }
  
-     }
  
  
+                 // Every expiration is a wakeup due at its own instant,
  
-     uint32_t getPeriod() const {
+                 // measured against that and not against another timer
  
-         return _period;
+                 // that fired in the same epoll_wait; the ones before the
  
-     }
+                 // last were missed and are as late as this wakeup
  
+                 auto& currentService = *scheduled[index];
  
+                 auto servicePeriod = armedPeriods[index];
  
-     // Print timing statistics (called after the service has stopped)
+                 for (uint64_t k = 0; k < expirations; k++)
  
-     void printStats() {
+                 {
  
-         std::lock_guard<std::mutex> lock(_statsMutex);
+                     _recordWakeup(nextReleaseVector[index] + k * servicePeriod, wakeTime);
+ 
+                 }
  
  
  
-         // If no samples were collected, just report no data
+                 // Release once for the most recent expiry; any earlier
  
-         if (_countStartJitter == 0 || _countExecTime == 0) {
+                 // expirations in the count are periods we never released
  
-             std::cout << "Service Stats: No samples collected.\n";
+                 // (replayed first, in order, for a catch-up service)
  
-             return;
+                 auto intendedTime = nextReleaseVector[index] + (expirations - 1) * servicePeriod;
  
-         }
+                 if (expirations > 1) {
  
+                     currentService.recordMissedReleases(nextReleaseVector[index], servicePeriod,
  
+                                                         expirations - 1);
  
-         double avgStartJitterUs = static_cast<double>(_sumStartJitterUs) / _countStartJitter;
+                 }
  
-         double avgExecTimeUs    = static_cast<double>(_sumExecTimeUs)    / _countExecTime;
+                 currentService.release(intendedTime);
  
  
  
-         std::cout << "Service Stats:\n";
+                 // A new period starts from this release
  
-         std::cout << "  Start Jitter (us):"
+                 auto newPeriod = currentService.getPeriod();
  
-                   << " min=" << _minStartJitterUs
+                 if (newPeriod != servicePeriod) {
  
-                   << " max=" << _maxStartJitterUs
+                     struct itimerspec its{};
  
-                   << " avg=" << avgStartJitterUs
+                     its.it_value    = toTimespec(duration_cast<nanoseconds>((intendedTime + newPeriod).time_since_epoch()));
  
-                   << " (based on " << _countStartJitter << " samples)\n";
+                     its.it_interval = toTimespec(newPeriod);
  
+                     if (timerfd_settime(timerFds[index], TFD_TIMER_ABSTIME, &its, nullptr) < 0) {
  
+                         std::cerr << "Sequencer: timerfd_settime failed: " << strerror(errno) << "\n";
  
-         std::cout << "  Execution Time (us):"
+                     }
+ 
+                     armedPeriods[index] = newPeriod;
+ 
+                     servicePeriod = newPeriod;
+ 
+                 }
+ 
+                 nextReleaseVector[index] = intendedTime + servicePeriod;
+ 
+             }
  
-                   << " min=" << _minExecTimeUs
+         }
+ 
+ 
+ 
+         for (int fd : timerFds)
  
-                   << " max=" << _maxExecTimeUs
+         {
+ 
+             if (fd >= 0)
  
-                   << " avg=" << avgExecTimeUs
+                 close(fd);
+ 
+         }
  
-                   << " (based on " << _countExecTime << " samples)\n";
+         close(epollFd);
  
      }
  
  
  
- private:
+     // Worst head-release -> tail-completion latency of a chain, over one
  
-     // User-supplied service function
+     // hyperperiod of head releases. Each stage runs on grid phase + k*period
  
-     std::function<void(void)> _doService;
+     // and takes its full worst response time; a stage picks up upstream
  
+     // data at its first release at or after the upstream completion.
  
+     static std::chrono::nanoseconds _pipelineLatency(const std::vector<std::chrono::nanoseconds>& periods,
  
-     // Thread and scheduling parameters
+                                                      const std::vector<std::chrono::nanoseconds>& phases,
  
-     std::jthread              _service;
+                                                      const std::vector<std::chrono::nanoseconds>& responses)
  
-     uint32_t                  _affinity;
+     {
  
-     uint32_t                  _priority;
+         using std::chrono::nanoseconds;
  
-     uint32_t                  _period;
+         if (periods.empty()) {
  
+             return nanoseconds{0};
  
+         }
  
-     // Synchronization
  
-     std::binary_semaphore     _releaseSemaphore;
  
-     std::atomic<bool>         _runningFlag;
+         // Releases on a grid at or after t
  
+         auto nextRelease = [](nanoseconds t, nanoseconds phase, nanoseconds period) {
  
+             if (t <= phase) {
  
-     // Timing stats
+                 return phase;
  
-     std::mutex _statsMutex;
+             }
+ 
+             return phase + ((t - phase + period - nanoseconds{1}) / period) * period;
  
-     // Last release time
+         };
  
-     std::chrono::steady_clock::time_point _releaseTime;
  
  
+         int64_t hyperperiod = periods[0].count();
  
-     // Start jitter stats (release->start)
+         for (const auto& period : periods)
  
-     long long _minStartJitterUs = std::numeric_limits<long long>::max();
+         {
  
-     long long _maxStartJitterUs = 0;
+             hyperperiod = std::lcm(hyperperiod, period.count());
  
-     long long _sumStartJitterUs = 0;
+         }
  
-     size_t    _countStartJitter = 0;
+         // Non-harmonic period sets can have huge hyperperiods; a bounded
  
+         // number of head releases still covers the relative offsets seen
  
+         int64_t headReleases = std::min<int64_t>(hyperperiod / periods[0].count(), 10000);
  
-     // Execution time stats (start->end)
  
-     long long _minExecTimeUs = std::numeric_limits<long long>::max();
  
-     long long _maxExecTimeUs = 0;
+         nanoseconds worst{0};
  
-     long long _sumExecTimeUs = 0;
+         for (int64_t k = 0; k < headReleases; k++)
  
-     size_t    _countExecTime = 0;
+         {
  
+             nanoseconds headRelease = phases[0] + k * periods[0];
  
+             nanoseconds done = headRelease + responses[0];
  
-     // Called once by the thread on startup (affinity, priority, etc. could be set here)
+             for (size_t i = 1; i < periods.size(); i++)
  
-     void _initializeService()
+             {
  
-     {
+                 done = nextRelease(done, phases[i], periods[i]) + responses[i];
  
-         // Optional:To set thread affinity, priority, etc. (platform-specific)
+             }
+ 
+             worst = std::max(worst, done - headRelease);
+ 
+         }
+ 
+         return worst;
  
      }
  
  
  
-     // Main loop for the service thread
+     // First point of a service's release grid, start + phase + period; a
  
-     void _provideService()
+     // service joining a grid that is already running takes the first of
+ 
+     // its grid points after now
+ 
+     static std::chrono::steady_clock::time_point _firstRelease(std::chrono::steady_clock::time_point start,
+ 
+                                                                const Service& service,
+ 
+                                                                std::chrono::steady_clock::time_point now)
  
      {
  
-         _initializeService();
+         auto period = service.getPeriod();
  
-         while (_runningFlag)
+         auto first = start + service.getPhase() + period;
  
-         {
+         if (first > now || period.count() <= 0) {
  
-             // Wait until the service is released
+             return first;
  
-             _releaseSemaphore.acquire();
+         }
  
-             if (!_runningFlag) {
+         return first + ((now - first) / period + 1) * period;
  
-                 break; // check again in case we were stopped
+     }
  
-             }
  
  
+     // Scheduler thread: append the services handed over by startServices()
  
-             // Capture start time
+     // and _insertService() to scheduled. Returns how many were added; only
  
-             auto startTime = std::chrono::steady_clock::now();
+     // takes the lock when there are any.
  
-             std::chrono::steady_clock::time_point localReleaseTime;
+     size_t _adoptPendingServices(std::vector<Service*>& scheduled)
  
+     {
  
+         if (!_servicesPending.load(std::memory_order_acquire)) {
  
-             {
+             return 0;
  
-                 // Copy the last release time for jitter measurement
+         }
  
-                 std::lock_guard<std::mutex> lock(_statsMutex);
+         std::lock_guard<std::mutex> lock(_pendingMutex);
  
-                 localReleaseTime = _releaseTime;
+         scheduled.insert(scheduled.end(), _pendingServices.begin(), _pendingServices.end());
  
-             }
+         size_t adopted = _pendingServices.size();
  
+         _pendingServices.clear();
  
+         _servicesPending = false;
  
-             // Calculate start-time jitter
+         return adopted;
  
-             auto startJitterUs = std::chrono::duration_cast<std::chrono::microseconds>(
+     }
  
-                 startTime - localReleaseTime
  
-             ).count();
  
+     // Pin the scheduler thread and make it the top SCHED_FIFO priority
  
+     void _initializeScheduler()
  
-             // Run the user-provided service function
+     {
  
-             _doService();
+         pthread_t threadId = pthread_self();
  
+         Tracer::instance().registerThread(); // before the first release it traces
  
  
-             // Capture end time
  
-             auto endTime = std::chrono::steady_clock::now();
+         cpu_set_t cpuSet;
  
-             auto execTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+         CPU_ZERO(&cpuSet);
  
-                 endTime - startTime
+         CPU_SET(_schedulerAffinity, &cpuSet);
  
-             ).count();
+         int affinityError = pthread_setaffinity_np(threadId, sizeof(cpuSet), &cpuSet);
  
  
  
-             // Update stats
+         struct sched_param param{};
  
-             {
+         param.sched_priority = sched_get_priority_max(SCHED_FIFO);
  
-                 std::lock_guard<std::mutex> lock(_statsMutex);
+         int policyError = pthread_setschedparam(threadId, SCHED_FIFO, &param);
  
  
  
-                 // Start jitter stats
+         std::lock_guard<std::mutex> lock(_reportMutex);
  
-                 if (startJitterUs < _minStartJitterUs) {
+         _schedulerInitReport = std::string("policy=SCHED_FIFO/") + std::to_string(param.sched_priority)
  
-                     _minStartJitterUs = startJitterUs;
+             + " " + rtStepResult(policyError)
  
-                 }
+             + ", affinity=cpu" + std::to_string(_schedulerAffinity) + " " + rtStepResult(affinityError);
  
-                 if (startJitterUs > _maxStartJitterUs) {
+     }
  
-                     _maxStartJitterUs = startJitterUs;
  
-                 }
  
-                 _sumStartJitterUs += startJitterUs;
+     // Scheduler thread only
  
-                 _countStartJitter++;
+     void _recordWakeup(std::chrono::steady_clock::time_point intended, std::chrono::steady_clock::time_point actual)
  
+     {
  
+         int64_t latencyNs = (actual - intended).count();
  
-                 // Execution time stats
+         _wakeupLatencyHist.recordSigned(latencyNs);
  
-                 if (execTimeUs < _minExecTimeUs) {
+         if (latencyNs > _wakeupThresholdNs.load(std::memory_order_relaxed)) {
  
-                     _minExecTimeUs = execTimeUs;
+             _lateWakeups.fetch_add(1, std::memory_order_relaxed);
  
-                 }
+         }
+ 
+     }
  
-                 if (execTimeUs > _maxExecTimeUs) {
  
-                     _maxExecTimeUs = execTimeUs;
  
-                 }
+     // Kick the scheduler out of its clock_nanosleep() (AbsoluteSleep) or
+ 
+     // out of epoll_wait (TimerFd) to see a stop or a new service now
+ 
+     void _wakeScheduler()
  
-                 _sumExecTimeUs += execTimeUs;
+     {
+ 
+         _sleep.wake();
+ 
+         if (_wakeFd >= 0) {
+ 
+             uint64_t one = 1;
  
-                 _countExecTime++;
+             if (write(_wakeFd, &one, sizeof(one)) < 0) {
+ 
+                 std::cerr << "Sequencer: failed to wake scheduler: " << strerror(errno) << "\n";
  
              }
  
@@ -368,169 +3606,273 @@
  
      }
  
- };
  
  
+     // True if target is reachable from source along precedence edges
  
- // The sequencer class contains the services set and manages
+     static bool _reaches(const Service* source, const Service* target)
  
- // starting/stopping the services. While the services are running,
+     {
  
- // the sequencer releases each service at the requisite timepoint.
+         if (source == target) {
  
- class Sequencer
+             return true;
  
- {
+         }
  
- public:
+         for (const Service* successor : source->getSuccessors())
  
-     template<typename... Args>
+         {
  
-     void addService(Args&&... args)
+             if (_reaches(successor, target)) {
+ 
+                 return true;
+ 
+             }
+ 
+         }
+ 
+         return false;
+ 
+     }
+ 
+ 
+ 
+     static std::string _label(const std::string& name, size_t index)
  
      {
  
-         // Construct a Service in-place and store it
+         return name.empty() ? "service" + std::to_string(index) : name;
+ 
+     }
+ 
  
-         _services.emplace_back(
  
-             std::make_unique<Service>(std::forward<Args>(args)...)
+     static std::string _label(const Service& service, size_t index)
  
-         );
+     {
+ 
+         return _label(service.getName(), index);
  
      }
  
  
  
-     void startServices()
+     // A period as the Service constructors take it: milliseconds as an
+ 
+     // integer, or any std::chrono duration
+ 
+     static std::chrono::nanoseconds _periodOf(uint32_t periodMs)
  
      {
  
-         _runningFlag = true;
+         return std::chrono::milliseconds(periodMs);
  
-         // Start a scheduler thread that periodically releases each service
+     }
  
-         _schedulerThread = std::jthread([this]()
  
-         {
  
-             using std::chrono::steady_clock;
+     template<typename Rep, typename Period>
  
-             using std::chrono::milliseconds;
+     static std::chrono::nanoseconds _periodOf(std::chrono::duration<Rep, Period> period)
+ 
+     {
  
-             using std::chrono::duration_cast;
+         return period;
  
+     }
  
  
-             std::vector<steady_clock::time_point> lastReleaseVector;
  
-             lastReleaseVector.reserve(_services.size());
+     // Admission control: the response-time (completion) test on the core
  
+     // the candidate would run on, against the services already pinned
  
+     // there. Periods and WCETs stay integer nanoseconds throughout, so the
  
-             // Initialize all last release times to "now"
+     // test is a few fixed-point iterations per service and cheap enough
  
-             auto currentTime = steady_clock::now();
+     // to run while the sequencer is live. kAutoAffinity services not yet
  
-             for (size_t i = 0; i < _services.size(); i++)
+     // placed load no core; SCHED_DEADLINE services are admitted by the
  
-             {
+     // kernel instead. The candidate is only a task model, not yet a
  
-                 lastReleaseVector.push_back(currentTime);
+     // Service; placedCore is set to the first core that passes (-1 if
  
-             }
+     // none was tested).
  
+     bool _admit(const TaskModel& candidate, int policy, uint8_t affinity, int& placedCore, std::string& verdict)
  
+     {
  
-             while (_runningFlag)
+         placedCore = -1;
  
-             {
+         if (policy == SCHED_DEADLINE || candidate.period.count() <= 0) {
  
-                 currentTime = steady_clock::now();
+             return true;
  
-                 // Check each service's period
+         }
  
-                 for (size_t i = 0; i < _services.size(); i++)
  
-                 {
  
-                     auto& servicePtr = _services[i];
+         size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
  
-                     auto& currentService = *servicePtr;
+         std::vector<size_t> candidateCores;
  
-                     auto servicePeriod = currentService.getPeriod();
+         if (affinity == kAutoAffinity) {
  
+             for (size_t core = 0; core < cores; core++) {
  
+                 candidateCores.push_back(core);
  
-                     auto elapsedTime = duration_cast<milliseconds>(
+             }
  
-                         currentTime - lastReleaseVector[i]
+         } else {
  
-                     ).count();
+             candidateCores.push_back(affinity);
  
+         }
  
  
-                     // If enough time has passed, release the service
  
-                     if (elapsedTime >= servicePeriod)
+         for (size_t core : candidateCores)
  
-                     {
+         {
  
-                         currentService.release();
+             std::vector<TaskModel> onCore{candidate};
  
-                         lastReleaseVector[i] = currentTime;
+             for (const Service* service : _snapshot())
  
-                     }
+             {
+ 
+                 if (service->getAffinity() == core && service->getPolicy() != SCHED_DEADLINE
+ 
+                     && service->getPeriod().count() > 0) {
+ 
+                     onCore.push_back(service->getTaskModel());
  
                  }
  
-                 // Sleep briefly to avoid busy-waiting
+             }
+ 
+             if (!isFeasible(onCore)) {
  
-                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                 continue;
  
              }
  
-         });
+             placedCore = static_cast<int>(core);
+ 
+             return true;
+ 
+         }
+ 
+         verdict = affinity == kAutoAffinity
+ 
+                       ? "no core passes the response-time test"
+ 
+                       : "cpu" + std::to_string(affinity) + " fails the response-time test";
+ 
+         return false;
  
      }
  
  
  
-     void stopServices()
+     // Services are only ever appended, never removed, so a Service* taken
+ 
+     // from _services under _servicesMutex stays valid without the lock
+ 
+     Service* _find(size_t id) const
  
      {
  
-         // Signal the scheduler to stop
+         std::lock_guard<std::mutex> lock(_servicesMutex);
+ 
+         return id < _services.size() ? _services[id].get() : nullptr;
+ 
+     }
  
-         _runningFlag = false;
  
  
+     std::vector<Service*> _snapshot() const
  
-         // Stop each service
+     {
  
-         for (auto& service : _services)
+         std::lock_guard<std::mutex> lock(_servicesMutex);
  
-         {
+         std::vector<Service*> services;
  
-             if (service)
+         services.reserve(_services.size());
  
-                 service->stop();
+         for (const auto& service : _services)
+ 
+         {
+ 
+             services.push_back(service.get());
  
          }
  
+         return services;
+ 
+     }
  
  
-         // Now print out each service's collected stats
  
-         // (the jthreads will join automatically as their Service objects go out of scope)
+     size_t _serviceCount() const
+ 
+     {
+ 
+         std::lock_guard<std::mutex> lock(_servicesMutex);
+ 
+         return _services.size();
+ 
+     }
+ 
+ 
+ 
+     // The scheduler thread releases its own list of the services, so one
+ 
+     // added while it runs is handed over through _pendingServices and
  
-         for (auto& service : _services)
+     // picked up as soon as the scheduler is woken, on the grid it already
+ 
+     // runs; nothing is stopped or restarted
+ 
+     void _insertService(std::unique_ptr<Service> service)
+ 
+     {
+ 
+         Service* added = service.get();
  
          {
  
-             if (service)
+             std::lock_guard<std::mutex> lock(_servicesMutex);
+ 
+             auto index = _services.size();
+ 
+             added->setTraceSource(static_cast<uint16_t>(index));
+ 
+             Tracer::instance().nameSource(static_cast<uint16_t>(index), _label(*added, index));
  
-                 service->printStats();
+             _services.push_back(std::move(service));
+ 
+         }
+ 
+         if (_schedulerThread.joinable()) {
+ 
+             {
+ 
+                 std::lock_guard<std::mutex> lock(_pendingMutex);
+ 
+                 _pendingServices.push_back(added);
+ 
+                 _servicesPending = true;
+ 
+             }
+ 
+             _wakeScheduler();
  
          }
  
@@ -538,12 +3880,52 @@
  
  
  
- private:
+     // _servicesMutex guards the vector, not the services in it: lookups
+ 
+     // and reconfiguration may come from any thread while a service is
+ 
+     // added. _addMutex keeps admission and insertion of one add atomic.
  
      std::vector<std::unique_ptr<Service>> _services;
  
+     mutable std::mutex                   _servicesMutex;
+ 
+     std::mutex                           _addMutex;
+ 
+     // Services waiting for the scheduler thread to adopt them
+ 
+     std::mutex                           _pendingMutex;
+ 
+     std::vector<Service*>                _pendingServices;
+ 
+     std::atomic<bool>                    _servicesPending{false};
+ 
+     WakeableSleep                        _sleep; // AbsoluteSleep backend's wait
+ 
      std::jthread                         _schedulerThread;
  
      std::atomic<bool>                    _runningFlag{false};
  
+     ReleaseBackend                       _backend{ReleaseBackend::AbsoluteSleep};
+ 
+     // eventfd used to wake the timerfd backend on stop
+ 
+     int                                  _wakeFd{-1};
+ 
+     uint8_t                              _schedulerAffinity{0};
+ 
+     // Written by the scheduler thread at startup, printed by stopServices()
+ 
+     std::mutex                           _reportMutex;
+ 
+     std::string                          _schedulerInitReport{"not run"};
+ 
+     // Scheduler self-latency, written only by the scheduler thread
+ 
+     LatencyHistogram                     _wakeupLatencyHist;
+ 
+     std::atomic<uint64_t>                _lateWakeups{0};
+ 
+     std::atomic<int64_t>                 _wakeupThresholdNs{100000};
+ 
  };
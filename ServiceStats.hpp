@@ -0,0 +1,189 @@
+/*
+ * ServiceStats.hpp - lock-free timing statistics for Sequencer services
+ *
+ * Every block of statistics has exactly one writer at a time. The service
+ * thread owns the execution numbers. The release-side numbers belong to
+ * whoever releases the service: the scheduler thread for a periodic
+ * service, or, for a service triggered by its dataflow predecessors
+ * (Sequencer::addPrecedence()), those predecessors' threads, which take
+ * the service's trigger mutex around each release so only one of them
+ * writes at a time. The sequencer never releases a triggered service, so
+ * the two kinds of releaser never mix on one service. The writer updates a
+ * private working copy and publishes it through a SeqLock, so the
+ * periodic hot path never takes a mutex and printStats() can take a
+ * consistent snapshot at any time. Releases themselves are handed to the
+ * service through a ReleaseQueue with one consumer and, by the same rule,
+ * one producer at a time.
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Single-writer sequence lock. The payload is stored as relaxed atomic
+// words, so readers racing with the writer are well defined and simply
+// retry when the sequence number shows a write in progress.
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock payload must be trivially copyable");
+    static_assert(sizeof(T) % sizeof(uint64_t) == 0, "SeqLock payload must be a whole number of words");
+
+public:
+    SeqLock()
+    {
+        store(T{});
+    }
+
+    // Writer side; one writer at a time (several writer threads must be
+    // serialized by the caller, as trigger() does with its mutex)
+    void store(const T& value)
+    {
+        uint64_t words[kWords];
+        std::memcpy(words, &value, sizeof(T));
+
+        uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Reader side; safe from any thread
+    T load() const
+    {
+        uint64_t words[kWords];
+        for (;;) {
+            uint64_t before = _sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // write in progress
+            }
+            for (size_t i = 0; i < kWords; i++) {
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = sizeof(T) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> _sequence{0};
+    std::atomic<uint64_t> _words[kWords];
+};
+
+// Bounded single-producer/single-consumer queue of pending releases. The
+// releasing thread pushes (the scheduler, or the predecessor holding a
+// triggered service's trigger mutex), the service thread pops; each entry
+// carries the intended and actual release instants (steady_clock ticks) of
+// one job.
+class ReleaseQueue
+{
+public:
+    static constexpr size_t kCapacity = 64;
+
+    struct Entry
+    {
+        int64_t intendedNs = 0;
+        int64_t releasedNs = 0;
+    };
+
+    // Producer side; false if the queue is full
+    bool push(const Entry& entry)
+    {
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= kCapacity) {
+            return false;
+        }
+        Slot& slot = _slots[tail % kCapacity];
+        slot.intendedNs.store(entry.intendedNs, std::memory_order_relaxed);
+        slot.releasedNs.store(entry.releasedNs, std::memory_order_relaxed);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false if the queue is empty
+    bool pop(Entry& entry)
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        const Slot& slot = _slots[head % kCapacity];
+        entry.intendedNs = slot.intendedNs.load(std::memory_order_relaxed);
+        entry.releasedNs = slot.releasedNs.load(std::memory_order_relaxed);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<int64_t> intendedNs{0};
+        std::atomic<int64_t> releasedNs{0};
+    };
+
+    alignas(64) std::atomic<uint64_t> _head{0};
+    alignas(64) std::atomic<uint64_t> _tail{0};
+    Slot _slots[kCapacity];
+};
+
+// Running min/max/sum/count of one quantity
+struct MinMaxSum
+{
+    int64_t  min   = std::numeric_limits<int64_t>::max();
+    int64_t  max   = std::numeric_limits<int64_t>::min();
+    int64_t  sum   = 0;
+    uint64_t count = 0;
+
+    void add(int64_t value)
+    {
+        if (value < min) {
+            min = value;
+        }
+        if (value > max) {
+            max = value;
+        }
+        sum += value;
+        count++;
+    }
+
+    double avg() const
+    {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+};
+
+// Written by the scheduler thread on every release
+struct ReleaseStats
+{
+    MinMaxSum lateness;        // intended release -> actual release
+    int64_t   lastLateness = 0;
+    uint64_t  missedReleases = 0;
+    uint64_t  overruns = 0;         // releases that found the previous job unfinished
+    uint64_t  droppedReleases = 0;  // overrunning releases discarded by the policy
+    uint64_t  maxBacklog = 0;       // most jobs outstanding at one release
+};
+
+// Written by the service thread after every execution
+struct ExecutionStats
+{
+    MinMaxSum startJitter;     // release -> start
+    MinMaxSum execTime;        // start -> end
+    MinMaxSum overrunLateness; // end -> next release, for jobs that ran past it
+    uint64_t  budgetOverruns = 0; // jobs that used up ServiceOptions::cpuBudget
+};
@@ -0,0 +1,347 @@
+/*
+ * StaticSequencer.hpp - Sequencer variant with a compile-time service set
+ *
+ * The dynamic Sequencer stores each service body in a std::function and
+ * decides at run time which services are due. Here every service is a
+ * StaticService<> type whose body, affinity, priority, period and phase are
+ * template parameters, so:
+ *
+ *   - service bodies are called directly (no type erasure, inlinable)
+ *   - the release schedule for one hyperperiod is a constexpr table of
+ *     frames (offset, mask of services released at that offset), so the
+ *     scheduler only sleeps to the next frame and releases its mask
+ *   - every thread is created in the constructor; nothing allocates once
+ *     the StaticSequencer is constructed
+ *
+ * Example:
+ *   void capture();
+ *   void control();
+ *   using Seq = StaticSequencer<
+ *       StaticService<capture, 1, 97, 256'000'000>,
+ *       StaticService<control, 1, 98, 500'000, 250'000>>;
+ *   Seq sequencer;
+ *   sequencer.startServices();
+ *
+ * A service that is still running when it is released again is not
+ * released a second time; the overrun is counted instead (skip policy).
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <numeric>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#include "LatencyHistogram.hpp"
+#include "ReleasePrimitive.hpp"
+#include "WakeableSleep.hpp"
+
+// One statically scheduled service. Function is a function pointer (or a
+// captureless lambda); PeriodNs and PhaseNs are in nanoseconds.
+template<auto Function, uint8_t Affinity, uint8_t Priority, uint64_t PeriodNs, uint64_t PhaseNs = 0>
+struct StaticService
+{
+    static_assert(PeriodNs > 0, "a static service needs a period");
+
+    static constexpr uint8_t  affinity = Affinity;
+    static constexpr uint8_t  priority = Priority;
+    static constexpr uint64_t periodNs = PeriodNs;
+    static constexpr uint64_t phaseNs  = PhaseNs % PeriodNs;
+
+    static void run()
+    {
+        Function();
+    }
+};
+
+template<typename... Services>
+class StaticSequencer
+{
+public:
+    static constexpr size_t kServiceCount = sizeof...(Services);
+    static_assert(kServiceCount > 0 && kServiceCount <= 64, "1 to 64 services (one mask bit each)");
+
+    // Everything is released relative to the start of a hyperperiod
+    static constexpr uint64_t kHyperperiodNs = []() {
+        uint64_t hyperperiod = 1;
+        ((hyperperiod = std::lcm(hyperperiod, Services::periodNs)), ...);
+        return hyperperiod;
+    }();
+
+    // Release instants in one hyperperiod, counted per service
+    static constexpr size_t kReleaseCount = ((kHyperperiodNs / Services::periodNs) + ...);
+    static_assert(kReleaseCount <= 16384, "hyperperiod too long for a static release table");
+
+private:
+    // The distinct release offsets in one hyperperiod, sorted, in the
+    // first count entries of offsets
+    struct _ReleaseInstants
+    {
+        std::array<uint64_t, kReleaseCount> offsets;
+        size_t                              count;
+    };
+
+    static constexpr _ReleaseInstants _releaseInstants()
+    {
+        constexpr uint64_t periods[] = {Services::periodNs...};
+        constexpr uint64_t phases[]  = {Services::phaseNs...};
+        std::array<uint64_t, kReleaseCount> instants{};
+        size_t n = 0;
+        for (size_t i = 0; i < kServiceCount; i++) {
+            for (uint64_t t = phases[i]; t < kHyperperiodNs; t += periods[i]) {
+                instants[n++] = t;
+            }
+        }
+        std::sort(instants.begin(), instants.end());
+        auto last = std::unique(instants.begin(), instants.end());
+        return {instants, static_cast<size_t>(last - instants.begin())};
+    }
+
+    static constexpr _ReleaseInstants kInstants = _releaseInstants();
+
+public:
+    template<size_t I>
+    using ServiceAt = std::tuple_element_t<I, std::tuple<Services...>>;
+
+    // Call visit.template operator()<I>() for each service I in mask. This
+    // is the scheduler's dispatch; it unrolls into one test per service.
+    template<typename Visitor>
+    static void forEachInMask(uint64_t mask, Visitor&& visit)
+    {
+        _forEachInMask(mask, visit, std::make_index_sequence<kServiceCount>{});
+    }
+
+    struct Frame
+    {
+        uint64_t offsetNs;    // from the start of the hyperperiod
+        uint64_t releaseMask; // bit i set: release service i
+    };
+
+    static constexpr size_t kFrameCount = kInstants.count;
+
+    // The release schedule, sorted by offset; one frame per distinct instant
+    static constexpr std::array<Frame, kFrameCount> kReleaseTable = []() {
+        const auto& instants = kInstants.offsets;
+        constexpr uint64_t periods[] = {Services::periodNs...};
+        constexpr uint64_t phases[]  = {Services::phaseNs...};
+        std::array<Frame, kFrameCount> table{};
+        for (size_t f = 0; f < kFrameCount; f++) {
+            table[f].offsetNs = instants[f];
+            for (size_t i = 0; i < kServiceCount; i++) {
+                if (instants[f] >= phases[i] && (instants[f] - phases[i]) % periods[i] == 0) {
+                    table[f].releaseMask |= uint64_t{1} << i;
+                }
+            }
+        }
+        return table;
+    }();
+
+    // Spawns every thread; the services wait for startServices()
+    StaticSequencer()
+    {
+        _spawnServices(std::make_index_sequence<kServiceCount>{});
+        _schedulerThread = std::jthread(&StaticSequencer::_schedulerLoop, this);
+    }
+
+    ~StaticSequencer()
+    {
+        _shutdown();
+    }
+
+    StaticSequencer(const StaticSequencer&) = delete;
+    StaticSequencer& operator=(const StaticSequencer&) = delete;
+
+    void startServices()
+    {
+        _runningFlag = true;
+        _start.post();
+    }
+
+    void stopServices()
+    {
+        _shutdown();
+
+        for (size_t i = 0; i < kServiceCount; i++)
+        {
+            const Slot& slot = _slots[i];
+            std::cout << "Static Service " << i << " Stats:"
+                      << " releases=" << slot.releases.load()
+                      << " executions=" << slot.executions.load()
+                      << " overruns=" << slot.overruns.load()
+                      << " rt=" << (slot.realtime ? "ok" : "FAILED") << "\n";
+        }
+        std::cout << "Static release table: " << kFrameCount << " frames per "
+                  << static_cast<double>(kHyperperiodNs) / 1e6 << "ms hyperperiod\n";
+        std::cout << "  Wakeup Latency (us): " << _wakeupLatency.summary() << "\n";
+        std::cout << "  Late Wakeups: " << _lateWakeups.load() << " over "
+                  << static_cast<double>(_wakeupThresholdNs.load()) / 1000.0 << "us\n";
+    }
+
+    // The scheduler records actual minus intended wakeup for every frame;
+    // wakeups later than threshold are counted as well
+    void setWakeupLatencyThreshold(std::chrono::nanoseconds threshold)
+    {
+        _wakeupThresholdNs = threshold.count();
+    }
+
+    const LatencyHistogram& getWakeupLatency() const
+    {
+        return _wakeupLatency;
+    }
+
+    uint64_t getOverruns(size_t service) const
+    {
+        return _slots[service].overruns.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getExecutions(size_t service) const
+    {
+        return _slots[service].executions.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Per-service release state, one cache line each
+    struct alignas(64) Slot
+    {
+        ReleasePrimitive      release{ReleasePrimitiveKind::Futex};
+        std::atomic<uint32_t> outstanding{0};
+        std::atomic<uint64_t> releases{0};
+        std::atomic<uint64_t> executions{0};
+        std::atomic<uint64_t> overruns{0};
+        bool                  realtime{false};
+    };
+
+    std::array<Slot, kServiceCount>         _slots;
+    std::array<std::jthread, kServiceCount> _serviceThreads;
+    std::jthread                            _schedulerThread;
+    ReleasePrimitive                        _start{ReleasePrimitiveKind::Futex};
+    std::atomic<bool>                       _runningFlag{false};
+    std::atomic<bool>                       _shutdownFlag{false};
+    WakeableSleep                           _sleep;         // the scheduler's wait for a frame
+    LatencyHistogram                        _wakeupLatency; // scheduler thread only
+    std::atomic<uint64_t>                   _lateWakeups{0};
+    std::atomic<int64_t>                    _wakeupThresholdNs{100000};
+
+    void _shutdown()
+    {
+        if (_shutdownFlag.exchange(true)) {
+            return;
+        }
+        _runningFlag = false;
+        _start.post();  // in case startServices() was never called
+        _sleep.wake();  // or it is between frames
+        if (_schedulerThread.joinable()) {
+            _schedulerThread.join();
+        }
+        for (size_t i = 0; i < kServiceCount; i++)
+        {
+            _slots[i].release.post();
+            if (_serviceThreads[i].joinable()) {
+                _serviceThreads[i].join();
+            }
+        }
+    }
+
+    template<size_t... I>
+    void _spawnServices(std::index_sequence<I...>)
+    {
+        ((_serviceThreads[I] = std::jthread(&StaticSequencer::_serviceLoop<I>, this)), ...);
+    }
+
+    template<size_t I>
+    void _serviceLoop()
+    {
+        using Service = ServiceAt<I>;
+        Slot& slot = _slots[I];
+        slot.realtime = _makeRealtime(Service::affinity, Service::priority);
+
+        for (;;)
+        {
+            slot.release.wait();
+            if (_shutdownFlag) {
+                break;
+            }
+            Service::run();
+            slot.executions.fetch_add(1, std::memory_order_relaxed);
+            slot.outstanding.store(0, std::memory_order_release);
+        }
+    }
+
+    // Cyclic executive: sleep to each frame of the table in turn
+    void _schedulerLoop()
+    {
+        _makeRealtime(0, static_cast<uint8_t>(sched_get_priority_max(SCHED_FIFO)));
+        _sleep.bind();
+        _start.wait();
+        if (_runningFlag) {
+            _runFrames();
+        }
+        _sleep.unbind();
+    }
+
+    void _runFrames()
+    {
+        auto origin = std::chrono::steady_clock::now();
+        for (uint64_t cycle = 0; _runningFlag; cycle++)
+        {
+            for (const Frame& frame : kReleaseTable)
+            {
+                auto due = origin + std::chrono::nanoseconds(cycle * kHyperperiodNs + frame.offsetNs);
+                if (!_sleep.sleepUntil(due)) {
+                    return; // woken: only _shutdown() wakes us
+                }
+                int64_t latencyNs = (std::chrono::steady_clock::now() - due).count();
+                if (!_runningFlag) {
+                    return;
+                }
+                _wakeupLatency.recordSigned(latencyNs);
+                if (latencyNs > _wakeupThresholdNs.load(std::memory_order_relaxed)) {
+                    _lateWakeups.fetch_add(1, std::memory_order_relaxed);
+                }
+                forEachInMask(frame.releaseMask, [this]<size_t I>() { _release<I>(); });
+            }
+        }
+    }
+
+    template<typename Visitor, size_t... I>
+    static void _forEachInMask(uint64_t mask, Visitor& visit, std::index_sequence<I...>)
+    {
+        ((mask & (uint64_t{1} << I) ? visit.template operator()<I>() : void()), ...);
+    }
+
+    template<size_t I>
+    void _release()
+    {
+        Slot& slot = _slots[I];
+        slot.releases.fetch_add(1, std::memory_order_relaxed);
+        if (slot.outstanding.exchange(1, std::memory_order_acq_rel) != 0) {
+            slot.overruns.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        slot.release.post();
+    }
+
+    static bool _makeRealtime(uint8_t core, uint8_t priority)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(core, &cpuSet);
+        bool pinned = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+
+        struct sched_param param{};
+        param.sched_priority = priority;
+        return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 && pinned;
+    }
+};
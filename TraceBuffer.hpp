@@ -0,0 +1,400 @@
+/*
+ * TraceBuffer.hpp - per-thread wait-free binary trace of scheduling events
+ *
+ * syslog() and per-run file appends on the release/execute path cost
+ * microseconds to milliseconds each, which shows up as the very jitter they
+ * are meant to measure. Here every thread that emits events gets its own
+ * single-producer ring of fixed 32-byte TraceEvent records, so emitting is
+ * a clock read, a CPU id read and a copy into the ring (no lock, no
+ * syscall, no allocation once the ring exists). registerThread() creates
+ * the calling thread's ring; every Sequencer service and scheduler thread
+ * calls it at startup, so their events never allocate. Any other thread
+ * that emits on a time-critical path should call it first too, or its
+ * first event allocates the ring and takes a lock. When a thread exits its
+ * ring goes back to a pool and the next thread to register takes it over,
+ * so threads that come and go (a SIGEV_THREAD timer starts one per expiry)
+ * reuse a few rings instead of each leaving 512 KiB behind. A drainer
+ * thread at SCHED_IDLE empties every ring into a binary file at a fixed
+ * interval. A full ring drops the event and counts it; the emitting
+ * thread never waits for the drainer.
+ *
+ * File layout (native endianness):
+ *   16-byte header: "RTTRACE\0", uint32 version, uint32 sizeof(TraceEvent)
+ *   TraceEvent records, in per-ring order (sort by timestampNs to merge)
+ *   A SourceName record carries the name length in value and is followed
+ *   by the name, zero-padded to a multiple of sizeof(TraceEvent)
+ * trace_export converts a trace file to Chrome Trace JSON.
+ *
+ * Usage:
+ *   Tracer::instance().start("run.trace");
+ *   Tracer::instance().nameSource(0, "camera");
+ *   traceEvent(TraceEventType::Start, 0);
+ *   traceMarker(7, frameNumber);
+ *   Tracer::instance().stop();
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+enum class TraceEventType : uint8_t
+{
+    Release    = 1, // a service was released; value = intended release (ns)
+    Start      = 2, // a job started; value = its intended release (ns)
+    End        = 3, // a job finished; value = its intended release (ns)
+    Overrun    = 4, // released while still busy; value = jobs outstanding
+    Marker     = 5, // user marker; source = marker id, value = user value
+    SourceName = 6  // file only: name of a source, see the layout above
+};
+
+inline const char* traceEventTypeName(TraceEventType type)
+{
+    switch (type) {
+    case TraceEventType::Release:    return "release";
+    case TraceEventType::Start:      return "start";
+    case TraceEventType::End:        return "end";
+    case TraceEventType::Overrun:    return "overrun";
+    case TraceEventType::Marker:     return "marker";
+    case TraceEventType::SourceName: return "name";
+    default:                         return "unknown";
+    }
+}
+
+struct TraceEvent
+{
+    uint64_t       timestampNs; // CLOCK_MONOTONIC (== steady_clock)
+    uint64_t       value;       // meaning depends on type
+    uint32_t       tid;         // emitting thread
+    uint16_t       source;      // service index or marker id
+    uint16_t       cpu;         // CPU the event was emitted on
+    TraceEventType type;
+    uint8_t        reserved[7];
+};
+static_assert(sizeof(TraceEvent) == 32, "trace records are 32 bytes on disk");
+
+constexpr char     kTraceMagic[8] = {'R', 'T', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t kTraceVersion  = 1;
+
+// Single-producer/single-consumer ring of trace events: the owning thread
+// pushes, the drainer pops
+class TraceRing
+{
+public:
+    static constexpr size_t kCapacity = 1 << 14; // events (512 KiB) per thread
+
+    // Producer side; false (and counted) if the ring is full
+    bool push(const TraceEvent& event)
+    {
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= kCapacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _slots[tail % kCapacity] = event;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; appends every queued event to out
+    size_t drain(std::vector<TraceEvent>& out)
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        uint64_t tail = _tail.load(std::memory_order_acquire);
+        for (uint64_t i = head; i < tail; i++) {
+            out.push_back(_slots[i % kCapacity]);
+        }
+        _head.store(tail, std::memory_order_release);
+        return static_cast<size_t>(tail - head);
+    }
+
+    uint64_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<uint64_t> _head{0};
+    alignas(64) std::atomic<uint64_t> _tail{0};
+    std::atomic<uint64_t>             _dropped{0};
+    alignas(64) std::array<TraceEvent, kCapacity> _slots{};
+};
+
+// Process-wide tracer: owns the per-thread rings, the source names and the
+// drainer thread. Emitting while the tracer is stopped costs one relaxed
+// load.
+class Tracer
+{
+public:
+    static Tracer& instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    ~Tracer()
+    {
+        stop();
+    }
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    // Open path and start draining into it every flushInterval. Returns
+    // false if the file cannot be opened or tracing is already on.
+    bool start(const std::string& path,
+               std::chrono::milliseconds flushInterval = std::chrono::milliseconds(20))
+    {
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        if (_file != nullptr) {
+            return false;
+        }
+        _file = std::fopen(path.c_str(), "wb");
+        if (_file == nullptr) {
+            return false;
+        }
+        uint32_t header[2] = {kTraceVersion, static_cast<uint32_t>(sizeof(TraceEvent))};
+        std::fwrite(kTraceMagic, sizeof(kTraceMagic), 1, _file);
+        std::fwrite(header, sizeof(header), 1, _file);
+        {
+            std::lock_guard<std::mutex> ringLock(_mutex);
+            _namesWritten = 0;
+        }
+
+        _flushInterval = flushInterval;
+        _draining = true;
+        _drainer = std::jthread(&Tracer::_drainLoop, this);
+        _enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Stop tracing, write out everything still queued and close the file
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(_controlMutex);
+        if (_file == nullptr) {
+            return;
+        }
+        _enabled.store(false, std::memory_order_release);
+        _draining = false;
+        if (_drainer.joinable()) {
+            _drainer.join();
+        }
+        _drainOnce();
+        std::fclose(_file);
+        _file = nullptr;
+    }
+
+    bool enabled() const
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    // Give source a name in the trace (cold path; any time, any thread)
+    void nameSource(uint16_t source, const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _names.emplace_back(source, name);
+    }
+
+    // Create the calling thread's ring now instead of at its first event,
+    // so the allocation, the registration lock and the page faults happen
+    // during initialization. Works whether or not tracing is on yet.
+    void registerThread()
+    {
+        if (_threadRing == nullptr) {
+            _registerThread();
+        }
+    }
+
+    // Events lost to full rings since the process started
+    uint64_t droppedEvents()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint64_t dropped = 0;
+        for (const auto& ring : _rings) {
+            dropped += ring->dropped();
+        }
+        return dropped;
+    }
+
+    // Hot path: record an event stamped now
+    void emit(TraceEventType type, uint16_t source, uint64_t value = 0)
+    {
+        if (!enabled()) {
+            return;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        _push(type, source, static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec, value);
+    }
+
+    // Hot path: record an event with a timestamp the caller already has
+    // (CLOCK_MONOTONIC / steady_clock ns), saving a clock read
+    void emitAt(TraceEventType type, uint16_t source, uint64_t timestampNs, uint64_t value = 0)
+    {
+        if (!enabled()) {
+            return;
+        }
+        _push(type, source, timestampNs, value);
+    }
+
+private:
+    Tracer() = default;
+
+    // A thread that skipped registerThread() pays for it at its first event
+    void _push(TraceEventType type, uint16_t source, uint64_t timestampNs, uint64_t value)
+    {
+        TraceRing* ring = _threadRing != nullptr ? _threadRing : _registerThread();
+        TraceEvent event{};
+        event.timestampNs = timestampNs;
+        event.value       = value;
+        event.tid         = _threadId;
+        event.source      = source;
+        event.cpu         = static_cast<uint16_t>(sched_getcpu());
+        event.type        = type;
+        ring->push(event);
+    }
+
+    // Hands a thread's ring back to the pool when the thread exits
+    struct _RingOwner
+    {
+        TraceRing* ring = nullptr;
+
+        ~_RingOwner()
+        {
+            if (ring != nullptr) {
+                Tracer::instance()._retire(ring);
+            }
+        }
+    };
+
+    // Take a ring from the pool, or allocate one. A pooled ring may still
+    // hold the previous owner's events; they are drained as usual, and the
+    // handover under _mutex orders its last push before our first.
+    TraceRing* _registerThread()
+    {
+        TraceRing* ring = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_freeRings.empty()) {
+                ring = _freeRings.back();
+                _freeRings.pop_back();
+            }
+        }
+        if (ring == nullptr) {
+            auto created = std::make_unique<TraceRing>();
+            ring = created.get();
+            std::lock_guard<std::mutex> lock(_mutex);
+            _rings.push_back(std::move(created)); // owned here for good; drained like any other
+        }
+        _threadRing       = ring;
+        _threadOwner.ring = ring;
+        _threadId         = static_cast<uint32_t>(gettid());
+        return ring;
+    }
+
+    void _retire(TraceRing* ring)
+    {
+        _threadRing = nullptr;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _freeRings.push_back(ring);
+    }
+
+    // Drainer thread: lowest priority there is, wakes every flushInterval
+    void _drainLoop()
+    {
+        struct sched_param param{};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+        while (_draining) {
+            std::this_thread::sleep_for(_flushInterval);
+            _drainOnce();
+        }
+    }
+
+    // Write new source names, then every ring's queued events
+    void _drainOnce()
+    {
+        std::vector<TraceRing*> rings;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (; _namesWritten < _names.size(); _namesWritten++) {
+                _writeName(_names[_namesWritten].first, _names[_namesWritten].second);
+            }
+            for (const auto& ring : _rings) {
+                rings.push_back(ring.get());
+            }
+        }
+        for (TraceRing* ring : rings) {
+            _batch.clear();
+            if (ring->drain(_batch) > 0) {
+                std::fwrite(_batch.data(), sizeof(TraceEvent), _batch.size(), _file);
+            }
+        }
+        std::fflush(_file);
+    }
+
+    void _writeName(uint16_t source, const std::string& name)
+    {
+        TraceEvent record{};
+        record.type   = TraceEventType::SourceName;
+        record.source = source;
+        record.value  = name.size();
+        std::fwrite(&record, sizeof(record), 1, _file);
+        std::vector<char> padded((name.size() + sizeof(TraceEvent) - 1) / sizeof(TraceEvent) * sizeof(TraceEvent));
+        std::memcpy(padded.data(), name.data(), name.size());
+        std::fwrite(padded.data(), 1, padded.size(), _file);
+    }
+
+    // _threadRing is what the hot path reads; _threadOwner (which has a
+    // destructor, so every access goes through a TLS wrapper) is only
+    // touched at registration
+    static inline thread_local TraceRing* _threadRing = nullptr;
+    static inline thread_local uint32_t   _threadId   = 0;
+    static thread_local _RingOwner        _threadOwner; // defined below the class
+
+    std::atomic<bool> _enabled{false};
+
+    // Guards _rings, _freeRings and _names (registration, thread exit and
+    // draining only)
+    std::mutex                                    _mutex;
+    std::vector<std::unique_ptr<TraceRing>>       _rings;
+    std::vector<TraceRing*>                       _freeRings; // of exited threads, for reuse
+    std::vector<std::pair<uint16_t, std::string>> _names;
+    size_t                                        _namesWritten{0};
+
+    // start()/stop() and the drainer
+    std::mutex                _controlMutex;
+    std::FILE*                _file{nullptr};
+    std::atomic<bool>         _draining{false};
+    std::chrono::milliseconds _flushInterval{20};
+    std::vector<TraceEvent>   _batch;
+    std::jthread              _drainer;
+};
+
+inline thread_local Tracer::_RingOwner Tracer::_threadOwner;
+
+inline void traceEvent(TraceEventType type, uint16_t source, uint64_t value = 0)
+{
+    Tracer::instance().emit(type, source, value);
+}
+
+inline void traceMarker(uint16_t id, uint64_t value = 0)
+{
+    Tracer::instance().emit(TraceEventType::Marker, id, value);
+}
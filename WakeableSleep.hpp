@@ -0,0 +1,126 @@
+/*
+ * WakeableSleep.hpp - absolute-time sleep that another thread can cut short
+ *
+ * clock_nanosleep(TIMER_ABSTIME) is the most direct way for a scheduler
+ * thread to wait for its next release, but nothing wakes it early: a stop,
+ * a restart or a newly added service has to wait for the sleep to run
+ * out, up to a whole period. WakeableSleep keeps clock_nanosleep for the
+ * wait and lets wake() interrupt it by sending sleepWakeSignal() to the
+ * sleeping thread, which makes the syscall return EINTR.
+ *
+ * A signal that lands after the thread has checked for a wake but before
+ * it has entered clock_nanosleep() would be lost, so the handler also
+ * zeroes the timespec the thread is about to sleep on: the syscall then
+ * returns at once instead of sleeping.
+ *
+ * Usage (one sleeping thread per WakeableSleep):
+ *   sleep.bind();                       // on the sleeping thread
+ *   if (!sleep.sleepUntil(due)) { }     // false: cut short by wake()
+ *   sleep.wake();                       // from any thread
+ *   sleep.unbind();                     // on the sleeping thread, before it exits
+ *
+ * Build with g++ --std=c++23 -Wall -Werror -pedantic
+ */
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <ctime>
+#include <mutex>
+#include <pthread.h>
+
+// Signal wake() sends to the sleeping thread; its handler does nothing
+// but end the sleep
+inline int sleepWakeSignal()
+{
+    return SIGRTMIN + 2;
+}
+
+inline struct timespec toTimespec(std::chrono::nanoseconds ns)
+{
+    struct timespec ts{};
+    ts.tv_sec  = static_cast<time_t>(ns.count() / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(ns.count() % 1000000000LL);
+    return ts;
+}
+
+class WakeableSleep
+{
+public:
+    WakeableSleep() = default;
+    WakeableSleep(const WakeableSleep&) = delete;
+    WakeableSleep& operator=(const WakeableSleep&) = delete;
+
+    // Make the calling thread the one wake() interrupts
+    void bind()
+    {
+        static std::once_flag handlerOnce;
+        std::call_once(handlerOnce, []() {
+            struct sigaction action{};
+            action.sa_handler = &WakeableSleep::_onWake;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = 0; // no SA_RESTART: the sleep must return EINTR
+            sigaction(sleepWakeSignal(), &action, nullptr);
+        });
+        std::lock_guard<std::mutex> lock(_mutex);
+        _thread = pthread_self();
+        _bound  = true;
+    }
+
+    // Stop wake() from signalling the calling thread; call before it exits
+    void unbind()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bound = false;
+    }
+
+    // Sleep until the absolute steady_clock (CLOCK_MONOTONIC) instant
+    // wakeTime. Returns true once it is reached, false if wake() cut the
+    // sleep short; either way a pending wake() is consumed.
+    bool sleepUntil(std::chrono::steady_clock::time_point wakeTime)
+    {
+        struct timespec ts = toTimespec(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            wakeTime.time_since_epoch()
+        ));
+        _threadTarget = &ts;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        while (!_wakeRequested.load(std::memory_order_acquire)
+               && clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+            // Some other signal; the deadline is absolute so just retry
+        }
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        _threadTarget = nullptr;
+        return !_wakeRequested.exchange(false, std::memory_order_acq_rel);
+    }
+
+    // End the current (or the next) sleepUntil() early. Any thread.
+    void wake()
+    {
+        _wakeRequested.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_bound) {
+            pthread_kill(_thread, sleepWakeSignal());
+        }
+    }
+
+private:
+    // Runs on the sleeping thread: a sleep not yet entered returns at once
+    static void _onWake(int)
+    {
+        if (_threadTarget != nullptr) {
+            _threadTarget->tv_sec  = 0;
+            _threadTarget->tv_nsec = 0;
+        }
+    }
+
+    static inline thread_local struct timespec* _threadTarget = nullptr;
+
+    // Guards the thread handle, so wake() never signals a thread that has
+    // unbound (and may have been joined)
+    std::mutex        _mutex;
+    pthread_t         _thread{};
+    bool              _bound{false};
+    std::atomic<bool> _wakeRequested{false};
+};
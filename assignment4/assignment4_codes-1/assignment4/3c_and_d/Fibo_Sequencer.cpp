@@ -297,6 +297,9 @@ int main()
 
     Sequencer sequencer{};
 
+    // per-job release/start/end trace, converted with trace_export
+    Tracer::instance().start("fibo_sequencer.trace");
+
     sequencer.addService(fib10, 0, 98, 20, 1);
 
     sequencer.addService(fib20, 0, 97, 50, 2);
@@ -314,6 +317,8 @@ int main()
 
     sequencer.stopServices();
 
+    Tracer::instance().stop();
+
     syslog(LOG_INFO, "Services stopped, exiting...");
 
     closelog();
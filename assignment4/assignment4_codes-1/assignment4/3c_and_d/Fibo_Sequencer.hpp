@@ -23,6 +23,7 @@
 #include <syslog.h>
 #include <mutex>
 #include <csignal>
+#include "../../../../TraceBuffer.hpp"
 
 double global_start_time;
 double getCurrentTimeInMs(void)
@@ -60,6 +61,7 @@ public:
         syslog(LOG_INFO, "affinity %d \n", static_cast<int>(_affinity));
         syslog(LOG_INFO, "priority  %d \n", static_cast<int>(_priority));
         syslog(LOG_INFO, "period %d   \n", static_cast<int>(_period));
+        Tracer::instance().nameSource(static_cast<uint16_t>(_service_identifier), "fib service " + std::to_string(_service_identifier));
         _service = std::jthread(&Service::_provideService, this); 
     }
 
@@ -74,6 +76,7 @@ public:
     void release()
     {
         // todo: release the service using the semaphore
+        traceEvent(TraceEventType::Release, static_cast<uint16_t>(_service_identifier));
         _semaphore.release();
     }
     //a getter to return private data
@@ -143,6 +146,7 @@ private:
     void _provideService()
     {
         _initializeService();
+        Tracer::instance().registerThread(); // trace ring allocated here, not at the first release
         while (_running)
         {
             _semaphore.acquire();
@@ -151,17 +155,17 @@ private:
 
             auto start_time = std::chrono::steady_clock::now();
 
-            auto start_time_ms = getCurrentTimeInMs() - global_start_time;
-            int cpu = sched_getcpu();
-            syslog(LOG_INFO, "Service %d started execution at %.2f ms core %d", _service_identifier, start_time_ms, cpu);
+            // start/end go to the trace ring (with the core they ran on)
+            // instead of syslog, which cost more than the jitter measured
+            Tracer::instance().emitAt(TraceEventType::Start, static_cast<uint16_t>(_service_identifier),
+                                      start_time.time_since_epoch().count());
             //call the service function
             _doService();
 
             auto end_time = std::chrono::steady_clock::now();
             auto exec_time = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-
-            auto end_time_ms = getCurrentTimeInMs() - global_start_time;
-            syslog(LOG_INFO, "Service %d finished execution at %.2f ms core %d", _service_identifier, end_time_ms, cpu);
+            Tracer::instance().emitAt(TraceEventType::End, static_cast<uint16_t>(_service_identifier),
+                                      end_time.time_since_epoch().count());
 
             std::chrono::milliseconds jitter(0);
             if (_service_identifier == 1)
@@ -221,35 +225,31 @@ private:
     {
         if (!_seq_running)
             return;
+        Tracer::instance().registerThread();
 
         // manually release services
         global_start_time = getCurrentTimeInMs(); //at this instant be record our inital time
         while (_seq_running)
         {
-            syslog(LOG_INFO, "CI INSTANT! %f \n", getCurrentTimeInMs() - global_start_time);
+            traceMarker(0); // start of a major cycle (CI)
             auto &service = _services;
             service[0]->release();
             service[1]->release();
 
             usleep(slep20Ms);
             service[0]->release();
-            syslog(LOG_INFO, "sequencer! %f \n", getCurrentTimeInMs() - global_start_time);
 
             usleep(slep20Ms);
             service[0]->release();
-            syslog(LOG_INFO, "sequencer! %f \n", getCurrentTimeInMs() - global_start_time);
 
             usleep(slep10MS);
             service[1]->release();
-            syslog(LOG_INFO, "sequencer! %f \n", getCurrentTimeInMs() - global_start_time);
 
             usleep(slep10MS);
             service[0]->release();
-            syslog(LOG_INFO, "sequencer! %f \n", getCurrentTimeInMs() - global_start_time);
 
             usleep(slep20Ms);
             service[0]->release();
-            syslog(LOG_INFO, "sequencer! %f \n", getCurrentTimeInMs() - global_start_time);
             usleep(slep20Ms);
         }
     }
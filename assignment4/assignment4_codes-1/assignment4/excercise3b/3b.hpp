@@ -19,6 +19,7 @@
 #include<iostream>
 #include <vector>
 #include <syslog.h>
+#include "../../../../LatencyHistogram.hpp"
 
 
 // The service class contains the service function and service parameters
@@ -152,6 +153,25 @@ public:
        {
            service->stop();
        }
+
+
+       // how late the timer thread woke from its 1 ms sleeps; this lateness
+       // ends up in every release
+       syslog(LOG_INFO, "Timer wakeup latency p50/p99/p99.9/max: %lu/%lu/%lu/%lu ns over %lu wakeups, %lu later than %lu ns",
+              static_cast<unsigned long>(_wakeup_hist.valueAtPercentile(50.0)),
+              static_cast<unsigned long>(_wakeup_hist.valueAtPercentile(99.0)),
+              static_cast<unsigned long>(_wakeup_hist.valueAtPercentile(99.9)),
+              static_cast<unsigned long>(_wakeup_hist.max()),
+              static_cast<unsigned long>(_wakeup_hist.count()),
+              static_cast<unsigned long>(_late_wakeups.load()),
+              static_cast<unsigned long>(_wakeup_threshold_ns));
+   }
+
+
+   // wakeups of the timer thread later than this are counted
+   void setWakeupThreshold(uint64_t threshold_ns)
+   {
+       _wakeup_threshold_ns = threshold_ns;
    }
 
 
@@ -159,6 +179,9 @@ private:
    std::vector<std::unique_ptr<Service>> _services; // Store services as unique_ptrs
    std::atomic<bool> _seq_running{false};
    std::jthread timer_thread;
+   LatencyHistogram _wakeup_hist; // actual - intended wakeup of timer_service, ns
+   std::atomic<uint64_t> _late_wakeups{0};
+   uint64_t _wakeup_threshold_ns{100000};
 //below Section of code written with chatgpt
    void timer_service()
    {
@@ -194,7 +217,14 @@ private:
            }
 
 
+           auto due = Clock::now() + std::chrono::milliseconds(1);
            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Small sleep to avoid busy waiting
+           auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count();
+           _wakeup_hist.recordSigned(latency);
+           if (latency > static_cast<int64_t>(_wakeup_threshold_ns))
+           {
+               _late_wakeups++;
+           }
        }
    }
 };
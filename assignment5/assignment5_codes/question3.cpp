@@ -17,6 +17,7 @@
 #include <cstring>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <poll.h>
 #define GPIO_BASE 512
 #define GPIO_TEST 18      // output pin
 #define GPIO_INPUT_PIN 23 // input pin
@@ -199,6 +200,45 @@ void poll_input_and_toggle_output()
     }
 }
 
+// extra credit question 6, event driven: wait for edges on the input pin via
+// the gpiochip line event interface and trigger the sporadic service once
+// per edge, instead of polling the pin in a busy loop
+void gpio_edge_events(Sequencer &sequencer)
+{
+    int chip_fd = open("/dev/gpiochip0", O_RDONLY);
+    if (chip_fd < 0)
+    {
+        syslog(LOG_ERR, "Unable to open /dev/gpiochip0 for input events");
+        return;
+    }
+    struct gpioevent_request rq{};
+    rq.lineoffset = GPIO_INPUT_PIN;
+    rq.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    rq.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+    strncpy(rq.consumer_label, "question3", sizeof(rq.consumer_label) - 1);
+    if (ioctl(chip_fd, GPIO_GET_LINEEVENT_IOCTL, &rq) < 0)
+    {
+        perror("GPIO_GET_LINEEVENT_IOCTL failed");
+        close(chip_fd);
+        return;
+    }
+
+    struct pollfd pfd{};
+    pfd.fd = rq.fd;
+    pfd.events = POLLIN;
+    while (main_running)
+    {
+        // time out now and then to notice ctrl-c
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        struct gpioevent_data event{};
+        if (read(rq.fd, &event, sizeof(event)) == sizeof(event))
+            sequencer.trigger(0);
+    }
+    close(rq.fd);
+    close(chip_fd);
+}
+
 int main(int argc, char *argv[])
 {
     struct sigaction action{};
@@ -250,18 +290,35 @@ int main(int argc, char *argv[])
     {
         syslog(LOG_WARNING, "Usage enter method 1-5 \n");
     }
+    // release/start/end of every job, binary, drained off the RT path;
+    // convert with trace_export
+    if (!Tracer::instance().start("service_trace" + std::to_string(method) + "_.trace"))
+        syslog(LOG_WARNING, "could not open the trace file, tracing disabled");
     if (method != 6)
         sequencer.addService(toggle_method, 1, 98, 1000, 1, method);
     else
-        sequencer.addService(toggle_method, 2, 98, DISABLE_AUTO_RELEASE, 1, method);
+        // sporadic server: at most 2 ms of core 2 in every 10 ms for input events
+        sequencer.addService(toggle_method, 2, 98, DISABLE_AUTO_RELEASE, 1, method, deadline_params{},
+                             sporadic_params{2000000, 10000000});
+    // deliver timer expirations to one SCHED_FIFO thread on core 0 instead of
+    // a fresh SIGEV_THREAD notification thread per millisecond
+    sequencer.setTimerMode(Sequencer::TimerMode::DedicatedThread, 0, 99);
+    // arm the timer only for actual release instants instead of every 1 ms
+    sequencer.setTickless(true);
     sequencer.startServices();
+    std::jthread edge_thread;
+    if (method == 6)
+        edge_thread = std::jthread(gpio_edge_events, std::ref(sequencer));
     // todo: wait for ctrl-c or some other terminating condition
     while (main_running)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
+    if (edge_thread.joinable())
+        edge_thread.join();
 
     sequencer.stopServices();
+    Tracer::instance().stop();
     syslog(LOG_INFO, "Services stopped, exiting...");
     closelog();
 }
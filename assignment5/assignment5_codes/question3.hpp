@@ -24,7 +24,56 @@
  #include <vector>
  #include <fstream>  
  #include <syslog.h>
+ #include <atomic>
+ #include <semaphore>
+ #include <chrono>
+ #include <limits>
+ #include <algorithm>
+ #include <unistd.h>
+ #include <mutex>
+ #include <cerrno>
+ #include <cstring>
+ #include <string>
+ #include <sys/syscall.h>
+ #include "../../LatencyHistogram.hpp"
+ #include "../../TraceBuffer.hpp"
  #define NSEC_PER_SEC (1000000000)
+ #define SCHED_FLAG_DL_OVERRUN_BIT 0x04 // kernel sends SIGXCPU on runtime overrun
+ 
+ // SCHED_DEADLINE reservation for a service; runtime_ns == 0 keeps the
+ // service on SCHED_FIFO. The reservation period is the service period and
+ // deadline_ns == 0 means deadline == period.
+ struct deadline_params
+ {
+     uint64_t runtime_ns = 0;
+     uint64_t deadline_ns = 0;
+ };
+ 
+ // sporadic server for an event driven service (period < 0). Events are
+ // served at the service priority while execution budget is left; the budget
+ // consumed by a job comes back replenish_period_ns after the job started.
+ // With the budget used up further events wait for the next replenishment,
+ // so a burst of events can take at most budget_ns of every
+ // replenish_period_ns from the periodic services. budget_ns == 0 serves
+ // every event immediately (no limit).
+ struct sporadic_params
+ {
+     uint64_t budget_ns = 0;
+     uint64_t replenish_period_ns = 0;
+ };
+ 
+ // kernel struct sched_attr, glibc has no sched_setattr() wrapper
+ struct sched_attr_t
+ {
+     uint32_t size;
+     uint32_t sched_policy;
+     uint64_t sched_flags;
+     int32_t sched_nice;
+     uint32_t sched_priority;
+     uint64_t sched_runtime;
+     uint64_t sched_deadline;
+     uint64_t sched_period;
+ };
  
  // The service class contains the service function and service parameters
  // (priority, affinity, etc). It spawns a thread to run the service, configures
@@ -33,13 +82,17 @@
  {
  public:
      template <typename T>
-     Service(T &&doService, uint8_t affinity, uint8_t priority, int period, int service_indetifier,int method) : _doService(doService),
+     Service(T &&doService, uint8_t affinity, uint8_t priority, int period, int service_indetifier,int method,
+             deadline_params deadline = {}, sporadic_params sporadic = {}) : _doService(doService),
                                                                                                            _affinity(affinity),
                                                                                                            _priority(priority),
                                                                                                            _period(period),
                                                                                                            _service_indetifier(service_indetifier),
                                                                                                            _method(method),
-                                                                                                           _semaphore(0)
+                                                                                                           _deadline(deadline),
+                                                                                                           _semaphore(0),
+                                                                                                           _sporadic(sporadic),
+                                                                                                           _budget_ns(static_cast<int64_t>(sporadic.budget_ns))
      {
          // todo: store service configuration values
          // todo: initialize release semaphore
@@ -50,6 +103,7 @@
          syslog(LOG_INFO, "priority  %d \n", static_cast<int>(_priority));
          syslog(LOG_INFO, "period %d   \n", static_cast<int>(_period));
            std::ofstream clear_file("service_runs" + std::to_string(_method) + "_.csv"); //clear previous logs
+         Tracer::instance().nameSource(static_cast<uint16_t>(service_indetifier), "service" + std::to_string(service_indetifier));
          _service = std::jthread(&Service::_provideService, this);
      }
  
@@ -59,11 +113,22 @@
          // (heads up: what if the service is waiting on the semaphore when this happens?)
          _running = false;
          _semaphore.release();
+         _event_semaphore.release();
+         _stop_wake.release(); // in case it is waiting for a replenishment
+     }
+ 
+     // release an event driven (period < 0) service once per event
+     void trigger()
+     {
+         traceEvent(TraceEventType::Release, static_cast<uint16_t>(_service_indetifier));
+         _events_triggered++;
+         _event_semaphore.release();
      }
  
      void release()
      {
          // todo: release the service using the semaphore
+         traceEvent(TraceEventType::Release, static_cast<uint16_t>(_service_indetifier));
          _semaphore.release();
      }
  
@@ -80,10 +145,55 @@
  syslog(LOG_INFO, "  Min Execution Time    : %.3f ms (%.0f ns)", _min_execution_time, _min_execution_time * 1e6);
  syslog(LOG_INFO, "  Max Execution Time    : %.3f ms (%.0f ns)", _max_execution_time, _max_execution_time * 1e6);
  syslog(LOG_INFO, "  Avg Execution Time    : %.3f ms (%.0f ns)", avg_time, avg_time * 1e6);
- syslog(LOG_INFO, "  Jitter  : %.3f ms (%.0f ns)", _max_execution_time-_min_execution_time, (_max_execution_time-_min_execution_time) * 1e6);
+ // max - min is the spread of execution times, not release jitter
+ syslog(LOG_INFO, "  Execution Time Range  : %.3f ms (%.0f ns)", _max_execution_time-_min_execution_time, (_max_execution_time-_min_execution_time) * 1e6);
+ syslog(LOG_INFO, "  Execution Time p50/p90/p99/p99.9/p99.99 : %lu/%lu/%lu/%lu/%lu ns",
+        static_cast<unsigned long>(_exec_hist.valueAtPercentile(50.0)),
+        static_cast<unsigned long>(_exec_hist.valueAtPercentile(90.0)),
+        static_cast<unsigned long>(_exec_hist.valueAtPercentile(99.0)),
+        static_cast<unsigned long>(_exec_hist.valueAtPercentile(99.9)),
+        static_cast<unsigned long>(_exec_hist.valueAtPercentile(99.99)));
+ if (_period < 0)
+ {
+     syslog(LOG_INFO, "  Sporadic server budget %lu ns per %lu ns: events triggered %lu, served %lu, deferred %lu",
+            static_cast<unsigned long>(_sporadic.budget_ns),
+            static_cast<unsigned long>(_sporadic.replenish_period_ns),
+            static_cast<unsigned long>(_events_triggered.load()),
+            static_cast<unsigned long>(_exec_count),
+            static_cast<unsigned long>(_events_deferred));
+ }
+ if (_deadline.runtime_ns > 0)
+ {
+     syslog(LOG_INFO, "  SCHED_DEADLINE admission: %s", _admission_result.c_str());
+     syslog(LOG_INFO, "  Runtime overruns (throttled): %lu", static_cast<unsigned long>(_deadline_overruns.load()));
+ }
  
      }
  
+     // append this service's run times (ms) to service_runs<method>_.csv;
+     // they are kept in a fixed ring while running so no job waits on file
+     // I/O or an allocation. A run longer than the ring keeps its latest
+     // RUN_LOG_CAPACITY jobs and reports how many older ones were dropped.
+     void flushRunLog()
+     {
+         std::ofstream run_time_logs("service_runs" + std::to_string(_method) + "_.csv", std::ios::app);
+         uint64_t first = _run_count > RUN_LOG_CAPACITY ? _run_count - RUN_LOG_CAPACITY : 0;
+         for (uint64_t run = first; run < _run_count; run++)
+             run_time_logs << _run_times[run % RUN_LOG_CAPACITY] << "\n";
+         if (first > 0)
+             syslog(LOG_INFO, "service %d run log kept the last %zu of %lu runs", _service_indetifier,
+                    RUN_LOG_CAPACITY, static_cast<unsigned long>(_run_count));
+         _run_count = 0;
+     }
+ 
+     // write the execution time histogram for hist.py (merge runs with hist.py --hdr)
+     void exportHistogram()
+     {
+         std::ofstream out("service_hist" + std::to_string(_method) + "_.csv");
+         out << LatencyHistogram::kCsvHeader << "\n";
+         _exec_hist.exportCsv(out, "service" + std::to_string(_service_indetifier) + ".execution_time");
+     }
+ 
  private:
      std::function<void(void)> _doService;
      std::jthread _service;
@@ -92,21 +202,93 @@
      int _period;
      int _service_indetifier;
      int _method;
+     deadline_params _deadline;
+     std::string _admission_result{"not attempted"};
+     std::atomic<uint64_t> _deadline_overruns{0};
+     static inline thread_local std::atomic<uint64_t> *_thread_overruns = nullptr;
      std::binary_semaphore _semaphore;
      std::atomic<bool> _running{true}; // Atomic boolean initialized to true
+ 
+     // sporadic server state, only touched by the service thread except the
+     // event semaphore and trigger count
+     struct replenishment
+     {
+         uint64_t at_ns;     // CLOCK_MONOTONIC
+         int64_t amount_ns;
+     };
+     static constexpr size_t MAX_REPLENISHMENTS = 32;
+     sporadic_params _sporadic;
+     int64_t _budget_ns; // may go negative: a job is only checked at its end
+     replenishment _replenishments[MAX_REPLENISHMENTS];
+     size_t _repl_head = 0;
+     size_t _repl_count = 0;
+     std::counting_semaphore<> _event_semaphore{0};
+     std::binary_semaphore _stop_wake{0}; // posted by stop() to end a replenishment wait
+     std::atomic<uint64_t> _events_triggered{0};
+     uint64_t _events_deferred = 0;
                                        
                                        // logging data
      double _min_execution_time = std::numeric_limits<double>::max();
      double _max_execution_time = std::numeric_limits<double>::min();
      double _accum_exec_time = 0;
      uint64_t _exec_count = 0;
+     LatencyHistogram _exec_hist; // execution time in ns, for percentiles
+     static constexpr size_t RUN_LOG_CAPACITY = 1 << 16; // latest runs kept for flushRunLog()
+     std::vector<double> _run_times = std::vector<double>(RUN_LOG_CAPACITY); // ms ring, allocated once
+     uint64_t _run_count = 0; // runs since the last flush; the next one goes in _run_times[_run_count % capacity]
+ 
  
+     static void _on_deadline_overrun(int)
+     {
+         if (_thread_overruns != nullptr)
+             _thread_overruns->fetch_add(1, std::memory_order_relaxed);
+     }
+ 
+     // put this thread under SCHED_DEADLINE; the kernel runs its admission
+     // test here (EBUSY = rejected). No CPU pinning: a deadline task must be
+     // allowed on its whole root domain.
+     void _initializeDeadlineService()
+     {
+         static std::once_flag handler_once;
+         std::call_once(handler_once, []()
+         {
+             struct sigaction action{};
+             action.sa_handler = &Service::_on_deadline_overrun;
+             sigemptyset(&action.sa_mask);
+             action.sa_flags = SA_RESTART;
+             sigaction(SIGXCPU, &action, nullptr);
+         });
+         _thread_overruns = &_deadline_overruns;
+ 
+         sched_attr_t attr{};
+         attr.size = sizeof(attr);
+         attr.sched_policy = SCHED_DEADLINE;
+         attr.sched_flags = SCHED_FLAG_DL_OVERRUN_BIT;
+         attr.sched_runtime = _deadline.runtime_ns;
+         attr.sched_period = static_cast<uint64_t>(_period) * 1000000ULL;
+         attr.sched_deadline = _deadline.deadline_ns ? _deadline.deadline_ns : attr.sched_period;
+         if (syscall(SYS_sched_setattr, 0, &attr, 0) == 0)
+             _admission_result = "accepted";
+         else if (errno == EBUSY)
+             _admission_result = "rejected (bandwidth exceeded)";
+         else
+             _admission_result = std::string("failed: ") + strerror(errno);
+         syslog(LOG_INFO, "Service %d SCHED_DEADLINE runtime %lu ns deadline %lu ns period %lu ns: %s",
+                _service_indetifier, static_cast<unsigned long>(attr.sched_runtime),
+                static_cast<unsigned long>(attr.sched_deadline),
+                static_cast<unsigned long>(attr.sched_period), _admission_result.c_str());
+     }
  
      void _initializeService()
      {
          // todo: set affinity, priority, sched policy
          // (heads up: the thread is already running and we're in its context right now)
          syslog(LOG_INFO, "Initializing service...");
+         if (_deadline.runtime_ns > 0 && _period > 0)
+         {
+             _initializeDeadlineService();
+             return;
+         }
          pthread_t threadID = pthread_self(); // Get current thread ID
          cpu_set_t cpuset;
          struct sched_param param;
@@ -133,37 +315,105 @@
      struct timespec service_end = {0, 0};
      struct timespec service_exec = {0, 0};
  
+     traceEvent(TraceEventType::Start, static_cast<uint16_t>(_service_indetifier));
      clock_gettime(CLOCK_REALTIME, &service_start);
      _doService();
      clock_gettime(CLOCK_REALTIME, &service_end);
+     traceEvent(TraceEventType::End, static_cast<uint16_t>(_service_indetifier));
  
      delta_t(&service_end, &service_start, &service_exec);
      double run_time = (service_exec.tv_sec * 1000.0) + (service_exec.tv_nsec / 1000000.0);
- 
-     std::ofstream run_time_logs;
-     run_time_logs.open("service_runs" + std::to_string(_method) + "_.csv", std::ios::app);
-     if (run_time_logs.is_open())
-     {
-         run_time_logs << run_time << "\n";
-         run_time_logs.close();
-     }
+     _run_times[_run_count++ % RUN_LOG_CAPACITY] = run_time;
  
      _exec_count++;
      _min_execution_time = std::min(_min_execution_time, run_time);
      _max_execution_time = std::max(_max_execution_time, run_time);
      _accum_exec_time += run_time;
+     _exec_hist.record(static_cast<uint64_t>(service_exec.tv_sec) * 1000000000ULL + service_exec.tv_nsec);
+ }
+ 
+ 
+ static uint64_t now_ns(clockid_t clock)
+ {
+     struct timespec ts;
+     clock_gettime(clock, &ts);
+     return static_cast<uint64_t>(ts.tv_sec) * NSEC_PER_SEC + ts.tv_nsec;
+ }
+ 
+ // give back every replenishment that is due at now
+ void _apply_replenishments(uint64_t now)
+ {
+     while (_repl_count > 0 && _replenishments[_repl_head].at_ns <= now)
+     {
+         _budget_ns += _replenishments[_repl_head].amount_ns;
+         _repl_head = (_repl_head + 1) % MAX_REPLENISHMENTS;
+         _repl_count--;
+     }
+ }
+ 
+ void _schedule_replenishment(uint64_t at, int64_t amount)
+ {
+     if (_repl_count == MAX_REPLENISHMENTS)
+     {
+         // no slot left: fold into the latest one, which only delays it
+         replenishment &last = _replenishments[(_repl_head + _repl_count - 1) % MAX_REPLENISHMENTS];
+         last.at_ns = std::max(last.at_ns, at);
+         last.amount_ns += amount;
+         return;
+     }
+     _replenishments[(_repl_head + _repl_count) % MAX_REPLENISHMENTS] = {at, amount};
+     _repl_count++;
  }
  
+ // one event of a sporadic server: wait for an event, wait for budget if it
+ // is used up, run the job and charge its CPU time to the budget
+ void _serve_event()
+ {
+     _event_semaphore.acquire();
+     if (!_running)
+         return;
+ 
+     if (_sporadic.budget_ns > 0)
+     {
+         _apply_replenishments(now_ns(CLOCK_MONOTONIC));
+         if (_budget_ns <= 0)
+             _events_deferred++;
+         while (_budget_ns <= 0 && _repl_count > 0 && _running)
+         {
+             // steady_clock is CLOCK_MONOTONIC; stop() ends the wait early
+             uint64_t at = _replenishments[_repl_head].at_ns;
+             std::chrono::steady_clock::time_point wake{std::chrono::nanoseconds(at)};
+             if (_stop_wake.try_acquire_until(wake))
+                 break;
+             _apply_replenishments(now_ns(CLOCK_MONOTONIC));
+         }
+         if (!_running)
+             return;
+     }
+ 
+     uint64_t activation = now_ns(CLOCK_MONOTONIC);
+     uint64_t cpu_start = now_ns(CLOCK_THREAD_CPUTIME_ID);
+     _runAndLog();
+     int64_t consumed = static_cast<int64_t>(now_ns(CLOCK_THREAD_CPUTIME_ID) - cpu_start);
+ 
+     if (_sporadic.budget_ns > 0)
+     {
+         _budget_ns -= consumed;
+         _schedule_replenishment(activation + _sporadic.replenish_period_ns, consumed);
+     }
+ }
  
  void _provideService()
  {
      _initializeService();
+     Tracer::instance().registerThread(); // trace ring allocated here, not at the first job
  
      while (_running)
      {
          if (_period < 0)
          {
-             _runAndLog();
+             // event driven: released by trigger(), no busy polling
+             _serve_event();
          }
          else
          {
@@ -223,21 +473,87 @@
          _services.emplace_back(std::make_unique<Service>(std::forward<Args>(args)...));
      }
  
+     // deliver one event to an event driven (period < 0) service, in the
+     // order services were added
+     void trigger(size_t service)
+     {
+         if (service < _services.size())
+             _services[service]->trigger();
+     }
+ 
+     // where timer expirations are delivered
+     enum class TimerMode
+     {
+         SigevThread,    // glibc notification thread per expiry (original behaviour)
+         DedicatedThread // one pre-created SCHED_FIFO thread waiting on a thread-directed signal
+     };
+ 
+     // choose the timer mode before startServices(); affinity and priority
+     // only apply to the dedicated timer thread
+     void setTimerMode(TimerMode mode, int affinity = 0, int priority = 99)
+     {
+         _timer_mode = mode;
+         _timer_affinity = affinity;
+         _timer_priority = priority;
+     }
+ 
+     // tickless operation: instead of a 1 ms tick, arm the timer one-shot
+     // for the next release instant across all services
+     void setTickless(bool tickless)
+     {
+         _tickless = tickless;
+     }
+ 
+     // every timer expiry records how late it was delivered (actual minus
+     // intended expiry, cyclictest style); expiries later than threshold_ns
+     // are also counted
+     void setWakeupThreshold(uint64_t threshold_ns)
+     {
+         _wakeup_threshold_ns = threshold_ns;
+     }
+ 
      void startServices()
      {
          // todo: start timer(s), release services
          _seq_running = true;
-         timer_service();
+         if (_timer_mode == TimerMode::DedicatedThread)
+             _timer_thread = std::jthread(&Sequencer::timer_thread_service, this);
+         else
+             timer_service();
      }
  
      void stopServices()
      {
          // todo: stop timer(s), stop services
          _seq_running = false;
+         if (_timer_thread.joinable())
+             _timer_thread.join();
+         else if (_timer_created)
+             timer_delete(posix_timer); // no more notification threads after this
+         _timer_created = false;
+         if (_tickless)
+             syslog(LOG_INFO, "Tickless timer expirations: %lu, overrun (missed) expirations: %lu",
+                    static_cast<unsigned long>(_timer_expirations.load()),
+                    static_cast<unsigned long>(_overrun_ticks.load()));
+         else
+             syslog(LOG_INFO, "Timer ticks: %lu, overrun (missed) ticks: %lu",
+                    static_cast<unsigned long>(_tick_counter.load()),
+                    static_cast<unsigned long>(_overrun_ticks.load()));
+         // timer lateness is part of every service's release jitter
+         syslog(LOG_INFO, "Timer wakeup latency p50/p99/p99.9/max: %lu/%lu/%lu/%lu ns over %lu expiries, %lu later than %lu ns",
+                static_cast<unsigned long>(_wakeup_hist.valueAtPercentile(50.0)),
+                static_cast<unsigned long>(_wakeup_hist.valueAtPercentile(99.0)),
+                static_cast<unsigned long>(_wakeup_hist.valueAtPercentile(99.9)),
+                static_cast<unsigned long>(_wakeup_hist.max()),
+                static_cast<unsigned long>(_wakeup_hist.count()),
+                static_cast<unsigned long>(_late_wakeups.load()),
+                static_cast<unsigned long>(_wakeup_threshold_ns));
          for (auto &service : _services)
          {
              service->stop();
              service->logStats();
+             service->flushRunLog();
+             service->exportHistogram();
          }
      }
  
@@ -246,28 +562,236 @@
      std::atomic<bool> _seq_running{false};
      timer_t posix_timer;
      std::atomic<uint64_t> _tick_counter{0};
+     std::atomic<uint64_t> _overrun_ticks{0}; // ticks reported by timer_getoverrun
+     TimerMode _timer_mode{TimerMode::SigevThread};
+     int _timer_affinity{0};
+     int _timer_priority{99};
+     bool _timer_created{false};
+     // tickless state: release instants are ns offsets from _start_time
+     bool _tickless{false};
+     struct timespec _start_time{};
+     std::vector<uint64_t> _next_release_ns;
+     std::atomic<uint64_t> _timer_expirations{0};
+     uint64_t _armed_ns{0}; // tickless: offset the one-shot is armed for
+     std::jthread _timer_thread;
+     // expiry delivery latency in ns; with SigevThread, notification threads
+     // rarely overlap, and if they do only min/max may miss a sample
+     LatencyHistogram _wakeup_hist;
+     std::atomic<uint64_t> _late_wakeups{0};
+     uint64_t _wakeup_threshold_ns{100000};
  
      static void timer_handler(union sigval sv)
      {
          auto *seq = static_cast<Sequencer *>(sv.sival_ptr);
          if (!seq->_seq_running)
              return;
-         uint64_t tick_time = ++seq->_tick_counter;
+         seq->on_timer_expiry();
+     }
+ 
+     void on_timer_expiry()
+     {
+         struct timespec now_ts;
+         clock_gettime(CLOCK_MONOTONIC, &now_ts);
+         if (_tickless)
+         {
+             record_wakeup(to_ns(_start_time) + _armed_ns, to_ns(now_ts));
+             release_due_and_rearm();
+             return;
+         }
+         // due at the first tick not yet counted, overruns included
+         record_wakeup(to_ns(_start_time) + (_tick_counter.load() + 1) * 1000000ULL, to_ns(now_ts));
+         int overrun = timer_getoverrun(posix_timer);
+         advance_ticks(1 + (overrun > 0 ? overrun : 0));
+     }
  
-         for (auto &service : seq->_services)
+     void record_wakeup(uint64_t intended_ns, uint64_t actual_ns)
+     {
+         int64_t latency = static_cast<int64_t>(actual_ns - intended_ns);
+         _wakeup_hist.recordSigned(latency);
+         if (latency > static_cast<int64_t>(_wakeup_threshold_ns))
+             _late_wakeups++;
+     }
+ 
+     static uint64_t to_ns(const struct timespec &ts)
+     {
+         return static_cast<uint64_t>(ts.tv_sec) * NSEC_PER_SEC + static_cast<uint64_t>(ts.tv_nsec);
+     }
+ 
+     // arm the timer at _start_time + offset_ns as an absolute one-shot
+     bool arm_one_shot(uint64_t offset_ns)
+     {
+         _armed_ns = offset_ns;
+         uint64_t when = to_ns(_start_time) + offset_ns;
+         struct itimerspec ts{};
+         ts.it_value.tv_sec = static_cast<time_t>(when / NSEC_PER_SEC);
+         ts.it_value.tv_nsec = static_cast<long>(when % NSEC_PER_SEC);
+         if (timer_settime(posix_timer, TIMER_ABSTIME, &ts, nullptr) == -1)
          {
-             if (tick_time % service->get_period() == 0)
+             perror("timer_settime");
+             return false;
+         }
+         return true;
+     }
+ 
+     // program the freshly created timer: periodic 1 ms ticks, or in
+     // tickless mode a one-shot at the first release of any service
+     bool arm_timer()
+     {
+         clock_gettime(CLOCK_MONOTONIC, &_start_time);
+         if (!_tickless)
+         {
+             // absolute first expiry, so tick k is due at exactly _start_time + k ms
+             uint64_t first = to_ns(_start_time) + 1000000;
+             struct itimerspec ts{};
+             ts.it_interval.tv_nsec = 1000000; // 1 ms b/w interval
+             ts.it_value.tv_sec = static_cast<time_t>(first / NSEC_PER_SEC);
+             ts.it_value.tv_nsec = static_cast<long>(first % NSEC_PER_SEC);
+             if (timer_settime(posix_timer, TIMER_ABSTIME, &ts, nullptr) == -1)
+             {
+                 perror("timer_settime");
+                 return false;
+             }
+             return true;
+         }
+ 
+         _next_release_ns.assign(_services.size(), std::numeric_limits<uint64_t>::max());
+         uint64_t first = std::numeric_limits<uint64_t>::max();
+         for (size_t i = 0; i < _services.size(); i++)
+         {
+             if (_services[i]->get_period() <= 0)
+                 continue; // not timer released
+             // first release one period after start, like the tick counter
+             _next_release_ns[i] = static_cast<uint64_t>(_services[i]->get_period()) * 1000000ULL;
+             first = std::min(first, _next_release_ns[i]);
+         }
+         if (first == std::numeric_limits<uint64_t>::max())
+             return true; // nothing periodic to release
+         return arm_one_shot(first);
+     }
+ 
+     // tickless expiry: release every service whose release instant has
+     // arrived, move each of them to its next instant on the absolute grid
+     // and re-arm the one-shot for the earliest one
+     void release_due_and_rearm()
+     {
+         _timer_expirations++;
+         struct timespec now_ts;
+         clock_gettime(CLOCK_MONOTONIC, &now_ts);
+         uint64_t now = to_ns(now_ts) - to_ns(_start_time);
+ 
+         uint64_t next = std::numeric_limits<uint64_t>::max();
+         for (size_t i = 0; i < _services.size(); i++)
+         {
+             if (_next_release_ns[i] == std::numeric_limits<uint64_t>::max())
+                 continue;
+             uint64_t period = static_cast<uint64_t>(_services[i]->get_period()) * 1000000ULL;
+             if (_next_release_ns[i] <= now)
+             {
+                 // more than one period behind means whole releases were missed
+                 uint64_t missed = (now - _next_release_ns[i]) / period;
+                 if (missed > 0)
+                 {
+                     _overrun_ticks += missed;
+                     syslog(LOG_WARNING, "service released %lu periods late (timer overrun)",
+                            static_cast<unsigned long>(missed));
+                 }
+                 _services[i]->release();
+                 _next_release_ns[i] += (missed + 1) * period;
+             }
+             next = std::min(next, _next_release_ns[i]);
+         }
+         if (_seq_running && next != std::numeric_limits<uint64_t>::max())
+             arm_one_shot(next);
+     }
+ 
+     // advance the tick counter by elapsed ticks and release every service
+     // whose period boundary was crossed. elapsed > 1 means the timer
+     // overran; a service whose boundary fell on a missed tick is released
+     // late (once) and the miss is logged instead of silently lost.
+     void advance_ticks(uint64_t elapsed)
+     {
+         uint64_t previous = _tick_counter.fetch_add(elapsed);
+         uint64_t tick_time = previous + elapsed;
+         if (elapsed > 1)
+             _overrun_ticks += elapsed - 1;
+ 
+         for (auto &service : _services)
+         {
+             if (service->get_period() <= 0)
+                 continue;
+             uint64_t period = static_cast<uint64_t>(service->get_period());
+             uint64_t last_boundary = tick_time - (tick_time % period);
+             if (last_boundary > previous)
              {
                  //syslog(LOG_INFO, "tick_time %ld \n", tick_time);
+                 if (last_boundary != tick_time)
+                     syslog(LOG_WARNING, "release at tick %lu was late by %lu ticks (timer overrun)",
+                            static_cast<unsigned long>(last_boundary),
+                            static_cast<unsigned long>(tick_time - last_boundary));
                  service->release();
              }
          }
      }
  
+     // dedicated timer thread: configure it as SCHED_FIFO on the chosen core,
+     // then have the POSIX timer signal this thread only (SIGEV_THREAD_ID)
+     // and wait for expirations synchronously with sigtimedwait
+     void timer_thread_service()
+     {
+         Tracer::instance().registerThread();
+         pthread_t threadID = pthread_self();
+         cpu_set_t cpuset;
+         struct sched_param param;
+         CPU_ZERO(&cpuset);
+         CPU_SET(_timer_affinity, &cpuset);
+         if (pthread_setaffinity_np(threadID, sizeof(cpu_set_t), &cpuset) != 0)
+         {
+             syslog(LOG_ERR, "Failed to set CPU affinity for timer thread.");
+         }
+         param.sched_priority = _timer_priority;
+         if (pthread_setschedparam(threadID, SCHED_FIFO, &param) != 0)
+         {
+             syslog(LOG_ERR, "Failed to set scheduling parameters for timer thread.");
+         }
+ 
+         // block the timer signal so it is only consumed by sigtimedwait
+         sigset_t timer_set;
+         sigemptyset(&timer_set);
+         sigaddset(&timer_set, SIGRTMIN);
+         pthread_sigmask(SIG_BLOCK, &timer_set, nullptr);
+ 
+         struct sigevent se{};
+         se.sigev_notify = SIGEV_THREAD_ID;
+         se.sigev_signo = SIGRTMIN;
+         se._sigev_un._tid = gettid(); // deliver to this thread only
+ 
+         if (timer_create(CLOCK_MONOTONIC, &se, &posix_timer) == -1)
+         {
+             syslog(LOG_ERR, "Unable to Create timer!");
+             return;
+         }
+         if (!arm_timer())
+         {
+             timer_delete(posix_timer);
+             return;
+         }
+         syslog(LOG_INFO, "Timer thread running on core %d with priority %d", _timer_affinity, _timer_priority);
+ 
+         // wake up periodically even without expirations so stop is noticed
+         struct timespec wait_limit{0, 100000000};
+         while (_seq_running)
+         {
+             siginfo_t info;
+             if (sigtimedwait(&timer_set, &info, &wait_limit) < 0)
+                 continue; // timeout or EINTR
+             on_timer_expiry();
+         }
+         timer_delete(posix_timer);
+     }
+ 
      // setup a posix timer
      void timer_service()
      {
-         struct itimerspec ts{};
          struct sigevent se{};
  
          // initlaize the sigevent structure to pass info to handler when timer is expired
@@ -275,25 +799,16 @@
          se.sigev_value.sival_ptr = this;
          se.sigev_notify_function = timer_handler; // call this function
  
-         // set timer to fire every 1ms
-         ts.it_interval.tv_sec = 0;
-         ts.it_interval.tv_nsec = 1000000; // 1 ms b/w interval
- 
-         ts.it_value.tv_sec = 0;
-         ts.it_value.tv_nsec = 1000000; // 1 ms for first expiration
- 
          // create the timer
          if (timer_create(CLOCK_MONOTONIC, &se, &posix_timer) == -1)
          {
              syslog(LOG_ERR, "Unable to Create timer!");
              return;
          }
+         _timer_created = true;
  
-         if (timer_settime(posix_timer, 0, &ts, nullptr) == -1)
-         {
-             perror("timer_settime");
-             return;
-         }
+         // fire every 1ms, or only at release instants when tickless
+         arm_timer();
      }
  };
  
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "cameraService.hpp"
 
 cv::Mat latest_frame;
-std::mutex frame_mutex;
+RtMutex frame_mutex{"frame"};
 
 //a global context for camera
 CameraContext cam;
@@ -97,7 +97,7 @@ void camera_capture_service() {
         cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
 
         {
-            std::lock_guard<std::mutex> lock(frame_mutex);
+            std::lock_guard<RtMutex> lock(frame_mutex);
             latest_frame = bgr.clone();
         }
 
@@ -4,6 +4,7 @@
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <mutex>
+#include "RtMutex.hpp"
 #include <fstream>
 #include <fcntl.h>
 #include <unistd.h>
@@ -29,7 +30,7 @@ typedef struct CameraContext{
 
 
 extern cv::Mat latest_frame;
-extern std::mutex frame_mutex;
+extern RtMutex frame_mutex;
 extern CameraContext cam;
 
 /*
@@ -1,4 +1,70 @@
 #include "config_update_service.hpp"
+#include <cmath>
+
+static Sequencer* bound_sequencer = nullptr;
+// Per service, the "services" values last applied successfully
+static nlohmann::json applied_services = nlohmann::json::object();
+
+void config_bind_sequencer(Sequencer* sequencer)
+{
+  bound_sequencer = sequencer;
+}
+
+// True if key is set for name and differs from what was last applied
+static bool service_setting_changed(const std::string& name, const nlohmann::json& settings, const char* key)
+{
+  if (!settings.contains(key)) {
+    return false;
+  }
+  auto applied = applied_services.find(name);
+  return applied == applied_services.end() || !applied->contains(key) || applied->at(key) != settings.at(key);
+}
+
+// Apply the fields of the "services" section that changed since they were
+// last applied; each change takes effect at that service's next release.
+// A rejected value is tried again at the next reload.
+static void apply_service_config(const nlohmann::json& services)
+{
+  if (bound_sequencer == nullptr) {
+    syslog(LOG_WARNING, "config: \"services\" section ignored, no sequencer bound");
+    return;
+  }
+  for (const auto& [name, settings] : services.items()) {
+    auto id = bound_sequencer->findService(name);
+    if (!id) {
+      syslog(LOG_WARNING, "config: no service named %s", name.c_str());
+      continue;
+    }
+    if (service_setting_changed(name, settings, "period_ms")) {
+      double period_ms = settings.at("period_ms");
+      auto period = std::chrono::nanoseconds(std::llround(period_ms * 1e6));
+      bool ok = bound_sequencer->setPeriod(*id, period);
+      if (ok) {
+        applied_services[name]["period_ms"] = settings.at("period_ms");
+      }
+      syslog(ok ? LOG_INFO : LOG_WARNING, "config: %s period %.3f ms %s", name.c_str(), period_ms,
+             ok ? "set" : "rejected");
+    }
+    if (service_setting_changed(name, settings, "priority")) {
+      int priority = settings.at("priority");
+      bool ok = priority >= 0 && priority <= 255 && bound_sequencer->setPriority(*id, static_cast<uint8_t>(priority));
+      if (ok) {
+        applied_services[name]["priority"] = priority;
+      }
+      syslog(ok ? LOG_INFO : LOG_WARNING, "config: %s priority %d %s", name.c_str(), priority,
+             ok ? "set" : "rejected");
+    }
+    if (service_setting_changed(name, settings, "affinity")) {
+      int core = settings.at("affinity");
+      bool ok = core >= 0 && core <= 255 && bound_sequencer->setAffinity(*id, static_cast<uint8_t>(core));
+      if (ok) {
+        applied_services[name]["affinity"] = core;
+      }
+      syslog(ok ? LOG_INFO : LOG_WARNING, "config: %s affinity cpu%d %s", name.c_str(), core,
+             ok ? "set" : "rejected");
+    }
+  }
+}
 
 void load_config(const std::string& filename)
 {
@@ -7,6 +73,10 @@ void load_config(const std::string& filename)
   
   file>>json_instance;
   
+  if (json_instance.contains("services")) {
+    apply_service_config(json_instance.at("services"));
+  }
+  
   auto colour=json_instance.at("colour");
   auto l1 = colour.at("lower1");
   auto u1 = colour.at("upper1");
@@ -19,7 +89,7 @@ void load_config(const std::string& filename)
         new_config.lower2 = cv::Scalar(l2[0], l2[1], l2[2]);
         new_config.upper2 = cv::Scalar(u2[0], u2[1], u2[2]);
      syslog(LOG_INFO,"loading new config");     
-   std::lock_guard<std::mutex> lock(config_mutex);
+   std::lock_guard<RtMutex> lock(config_mutex);
    config = new_config;
 
   
@@ -4,8 +4,17 @@
 #include <opencv2/opencv.hpp>
 #include "red_laser_service.hpp"
 #include <fstream>
+#include "RtMutex.hpp"
 
 extern HSVConfig config; 
-extern 	std::mutex config_mutex;
+extern 	RtMutex config_mutex;
+
+#include "Sequencer.hpp"
 
 void config_update_service();
+
+// Sequencer whose services the optional "services" section of CONFIG_FILE
+// retunes live, by service name:
+//   "services": { "camera": { "period_ms": 256, "priority": 97, "affinity": 1 } }
+// Any of the three keys may be left out.
+void config_bind_sequencer(Sequencer* sequencer);
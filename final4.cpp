@@ -23,7 +23,18 @@
 #define HEIGHT 480
 #define NBUF 4
 
-struct Point2D { int x, y; };
+// Provenance of a result: the camera frame it was computed from. Each
+// stage records how long after the previous stage published the token it
+// publishes its own result, then restamps it; the motor stage also records
+// sensor -> first GPIO write, the latency that decides whether the robot
+// keeps up with the laser.
+struct FrameToken {
+    uint32_t sequence    = 0; // v4l2_buffer.sequence
+    int64_t  captureNs   = 0; // sensor timestamp, steady_clock ns
+    int64_t  publishedNs = 0; // when the last stage handed it on
+};
+
+struct Point2D { int x, y; FrameToken token; };
 
 enum Direction {
     STOP,
@@ -37,22 +48,70 @@ enum Direction {
 struct MovementCommand {
     Direction dir;
     int speed_level;  // 1..3
+    FrameToken token;
 };
 
 // === Shared buffers & state ===
-cv::Mat latest_frame;
-std::mutex frame_mutex;
+// Priority-inheritance locks (RtMutex.hpp); their wait and hold times
+// print with the service stats
+cv::Mat    latest_frame;
+FrameToken latest_frame_token;
+RtMutex    frame_mutex{"frame"};
 
 std::optional<Point2D> latest_laser_point;
-std::mutex             point_mutex;
+RtMutex                point_mutex{"point"};
 std::atomic<bool>      point_available{false};
 
 std::optional<MovementCommand> latest_cmd;
-std::mutex                     cmd_mutex;
+RtMutex                        cmd_mutex{"cmd"};
 std::atomic<bool>              cmd_available{false};
 
 std::atomic<bool> stop_requested{false};
 
+// === Frame-to-actuation latency ===
+// ns histograms, each written only by the service of its stage, with at
+// most one sample per frame: a stage that sees the same frame again (a
+// job re-run on an unchanged input) does not count it twice
+struct StageLatency {
+    LatencyHistogram        histogram;
+    std::optional<uint32_t> last_sequence; // frame of the latest sample
+
+    void record(uint32_t sequence, int64_t ns) {
+        if (last_sequence == sequence) return;
+        last_sequence = sequence;
+        histogram.recordSigned(ns);
+    }
+};
+StageLatency capture_latency;    // sensor timestamp -> frame published
+StageLatency detect_latency;     // frame published -> laser point published
+StageLatency decide_latency;     // point published -> command published
+StageLatency actuate_latency;    // command published -> first GPIO write
+StageLatency end_to_end_latency; // sensor timestamp -> first GPIO write
+
+// Trace markers (TraceBuffer.hpp), value = frame sequence
+constexpr uint16_t kFrameCapturedMarker = 1;
+constexpr uint16_t kActuationMarker     = 2;
+
+static int64_t monotonic_ns() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+// Close a stage: record its latency and hand the token on
+static void stamp_stage(FrameToken& token, StageLatency& stage) {
+    int64_t now = monotonic_ns();
+    stage.record(token.sequence, now - token.publishedNs);
+    token.publishedNs = now;
+}
+
+// Sensor timestamp of a dequeued buffer. Drivers that stamp with
+// CLOCK_MONOTONIC (UVC cameras do) say so in the flags; for any other
+// clock fall back to the dequeue time.
+static int64_t buffer_timestamp_ns(const v4l2_buffer& buf) {
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+        return int64_t(buf.timestamp.tv_sec) * 1000000000LL + int64_t(buf.timestamp.tv_usec) * 1000LL;
+    return monotonic_ns();
+}
+
 // === Camera buffer setup ===
 struct Buffer { void* start; size_t length; };
 struct CameraContext {
@@ -109,16 +168,26 @@ void camera_capture_service() {
     buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
     if (ioctl(cam.fd, VIDIOC_DQBUF, &buf) < 0) {
+        // No new frame: detect has nothing new to work on
+        Service::suppressSuccessors();
         if (errno == EAGAIN) return;
         perror("Retrieving Frame"); return;
     }
 
+    FrameToken token;
+    token.sequence    = buf.sequence;
+    token.captureNs   = buffer_timestamp_ns(buf);
+    token.publishedNs = token.captureNs;
+    traceMarker(kFrameCapturedMarker, token.sequence);
+
     cv::Mat yuyv(HEIGHT, WIDTH, CV_8UC2, cam.buffers[buf.index].start);
     cv::Mat bgr;
     cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
     {
         std::lock_guard lock(frame_mutex);
         latest_frame = bgr.clone();
+        stamp_stage(token, capture_latency);
+        latest_frame_token = token;
     }
 
     if (ioctl(cam.fd, VIDIOC_QBUF, &buf) < 0) { perror("Requeue Buffer"); }
@@ -126,12 +195,20 @@ void camera_capture_service() {
 
 // Service 2: red‑laser detect
 void red_laser_detect_and_show() {
+    static std::optional<uint32_t> last_sequence; // frame of the previous job
     cv::Mat frame_copy;
+    FrameToken token;
     {
         std::lock_guard lock(frame_mutex);
-        if (latest_frame.empty()) return;
+        if (latest_frame.empty() || last_sequence == latest_frame_token.sequence) {
+            Service::suppressSuccessors(); // no frame yet, or already processed
+            return;
+        }
         frame_copy = latest_frame.clone();
+        token = latest_frame_token;
     }
+    last_sequence = token.sequence;
+    bool stamped = false;
 
     cv::Mat hsv, mask, l, u;
     cv::cvtColor(frame_copy, hsv, cv::COLOR_BGR2HSV);
@@ -143,7 +220,14 @@ void red_laser_detect_and_show() {
 
     std::vector<std::vector<cv::Point>> C;
     cv::findContours(mask, C, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-    for (auto &cnt : C) {
+    for (size_t index = 0; index < C.size(); ++index) {
+        const auto &cnt = C[index];
+        // A noisy frame can yield thousands of contours; give up on this
+        // frame rather than run past the CPU budget
+        if (Service::abortRequested()) {
+            syslog(LOG_WARNING, "laser detect: CPU budget used up, %zu contours skipped", C.size() - index);
+            break;
+        }
         if (cv::contourArea(cnt) < 50) continue;
         auto M = cv::moments(cnt);
         if (M.m00 == 0) continue;
@@ -152,10 +236,17 @@ void red_laser_detect_and_show() {
         cv::circle(frame_copy, {cx, cy}, 5, {0,255,0}, -1);
         {
             std::lock_guard lock(point_mutex);
-            latest_laser_point = Point2D{cx, cy};
+            if (!stamped) {
+                stamp_stage(token, detect_latency); // the frame's first point closes the stage
+                stamped = true;
+            }
+            latest_laser_point = Point2D{cx, cy, token};
             point_available.store(true, std::memory_order_release);
         }
     }
+    if (!stamped) {
+        Service::suppressSuccessors(); // no laser point: nothing to decide on
+    }
    //cv::imshow("Laser", frame_copy);
    //cv::waitKey(1);
 }
@@ -176,7 +267,10 @@ MovementCommand service3_decide_direction(Point2D pos) {
 }
 
 void service3_thread() {
-    if (!point_available.load(std::memory_order_acquire)) return;
+    if (!point_available.load(std::memory_order_acquire)) {
+        Service::suppressSuccessors();
+        return;
+    }
 
     std::optional<Point2D> p;
     {
@@ -187,8 +281,10 @@ void service3_thread() {
     if (!p) return;
 
     auto cmd = service3_decide_direction(*p);
+    cmd.token = p->token;
     {
         std::lock_guard lock(cmd_mutex);
+        stamp_stage(cmd.token, decide_latency);
         latest_cmd = cmd;
         cmd_available.store(true, std::memory_order_release);
     }
@@ -212,6 +308,7 @@ void service3_thread() {
 struct MotorDriver {
     int chipFd{-1}, lineFd{-1};
     gpiohandle_data data{};
+    int64_t firstWriteNs{0}; // first GPIO write of the last drive() burst
     // offsets: IN1,IN2,IN3,IN4, ENA, ENB
     unsigned offsets[6]{17,27,22,23, 18, 19};
 
@@ -255,12 +352,14 @@ struct MotorDriver {
 
         auto t_start = std::chrono::steady_clock::now();
         auto t_end   = t_start + std::chrono::milliseconds(burst_ms);
+        firstWriteNs = 0;
 
         while (std::chrono::steady_clock::now() < t_end) {
             // HIGH phase: enable motors
             data.values[4] = (A||B) ? 1 : 0;  // ENA
             data.values[5] = (C||D) ? 1 : 0;  // ENB
             ioctl(lineFd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+            if (firstWriteNs == 0) firstWriteNs = monotonic_ns();
             std::this_thread::sleep_for(std::chrono::milliseconds(high_ms));
 
             // LOW phase: brake
@@ -323,6 +422,13 @@ void service4_motor_control() {
     // burst for e.g. 100ms (or scale by speed)
     int burst_ms = 25;  
     drv.drive(A,B,C,D, speed, burst_ms, dirStr);
+
+    // The command's frame reached the motors
+    if (c && drv.firstWriteNs != 0) {
+        actuate_latency.record(c->token.sequence, drv.firstWriteNs - c->token.publishedNs);
+        end_to_end_latency.record(c->token.sequence, drv.firstWriteNs - c->token.captureNs);
+        traceMarker(kActuationMarker, c->token.sequence);
+    }
 }
 
 // Signal handler
@@ -337,20 +443,61 @@ int main(){
 
     if (init_camera()) return 1;
 
+    // Release/start/end of every job, drained to disk off the RT path;
+    // convert with trace_export
+    if (!Tracer::instance().start("final4.trace"))
+        syslog(LOG_WARNING, "Could not open final4.trace, tracing disabled");
+
     Sequencer seq;
-    seq.addService(camera_capture_service,     1, 97,  256, 1, 1);
-    seq.addService(red_laser_detect_and_show,  1, 96,  128, 2, 2);
-    seq.addService(service3_thread,            1, 95,  64, 3, 3);
-    seq.addService(service4_motor_control,     1, 98,  32, 4, 4);
+    seq.addService(camera_capture_service,     kAutoAffinity, 97,  256, ServiceOptions{.name = "camera"});
+    seq.addService(red_laser_detect_and_show,  kAutoAffinity, 96,  128,
+                   ServiceOptions{.name = "red_laser_detect", .cpuBudget = std::chrono::milliseconds(40),
+                                  .budgetAction = BudgetAction::Abort, .perfCounters = true});
+    seq.addService(service3_thread,            kAutoAffinity, 95,  64,  ServiceOptions{.name = "decide_direction"});
+    seq.addService(service4_motor_control,     kAutoAffinity, 98,  32,  ServiceOptions{.name = "motor_control"});
+
+    // Dataflow: each stage is released as soon as its upstream stage
+    // completes instead of polling on its own period, which now only
+    // limits how often it can run
+    seq.addPrecedence(0, 1);
+    seq.addPrecedence(1, 2);
+    seq.addPrecedence(2, 3);
 
     seq.startServices();
     syslog(LOG_INFO,"All services started.");
 
+    // Measure execution and response times for a few camera periods, then
+    // spread the services over the cores by measured utilization
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    if (!stop_requested) {
+        auto partition = seq.partitionServices();
+        syslog(LOG_INFO, "Services partitioned over %zu cores, %s", partition.utilization.size(),
+               partition.feasible ? "feasible" : "NOT feasible");
+    }
+
     while (!stop_requested) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
     seq.stopServices();
+    Tracer::instance().stop();
+
+    std::cout << "Frame-to-actuation latency (us):\n"
+              << "  capture (sensor->frame):   " << capture_latency.histogram.summary() << "\n"
+              << "  detect  (frame->point):    " << detect_latency.histogram.summary() << "\n"
+              << "  decide  (point->command):  " << decide_latency.histogram.summary() << "\n"
+              << "  actuate (command->GPIO):   " << actuate_latency.histogram.summary() << "\n"
+              << "  end to end (sensor->GPIO): " << end_to_end_latency.histogram.summary() << "\n";
+
+    // Every histogram, for hist.py --hdr
+    if (seq.exportHistograms("final4_hist.csv")) {
+        std::ofstream csv("final4_hist.csv", std::ios::app);
+        capture_latency.histogram.exportCsv(csv, "pipeline.capture");
+        detect_latency.histogram.exportCsv(csv, "pipeline.detect");
+        decide_latency.histogram.exportCsv(csv, "pipeline.decide");
+        actuate_latency.histogram.exportCsv(csv, "pipeline.actuate");
+        end_to_end_latency.histogram.exportCsv(csv, "pipeline.end_to_end");
+    }
     syslog(LOG_INFO,"Services stopped, exiting.");
     return 0;
 }
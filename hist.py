@@ -2,10 +2,63 @@
 # Code to plot histograms of different methods of pin toggling
 # Not original work generated with LLM
 
+import sys
+import numpy as np
 import pandas as pd
 import seaborn as sns
 import matplotlib.pyplot as plt
 
+
+# HDR mode: python3 hist.py --hdr service_hist.csv [more.csv ...]
+# Reads "# metric,low_ns,high_ns,count" bucket files written by
+# LatencyHistogram::exportCsv(), merges the same metric across all files
+# (counts simply add) and plots each metric on a log latency axis.
+def percentile(buckets, pct):
+    total = buckets["count"].sum()
+    rank = max(1, int(np.ceil(pct / 100.0 * total)))
+    cumulative = buckets["count"].cumsum()
+    return buckets["high_ns"][cumulative >= rank].iloc[0]
+
+
+def plot_hdr(paths):
+    frames = [pd.read_csv(path, comment="#", header=None,
+                          names=["metric", "low_ns", "high_ns", "count"]) for path in paths]
+    merged = (pd.concat(frames, ignore_index=True)
+              .groupby(["metric", "low_ns", "high_ns"], as_index=False)["count"].sum()
+              .sort_values(["metric", "low_ns"]))
+
+    metrics = list(merged["metric"].unique())
+    fig, axes = plt.subplots(len(metrics), 1, figsize=(14, 4 * len(metrics)), squeeze=False)
+
+    print("\nMerged percentiles (us) from " + ", ".join(paths) + ":")
+    for i, metric in enumerate(metrics):
+        buckets = merged[merged["metric"] == metric].reset_index(drop=True)
+        ax = axes[i][0]
+        ax.bar(buckets["low_ns"] / 1000.0, buckets["count"],
+               width=(buckets["high_ns"] - buckets["low_ns"] + 1) / 1000.0,
+               align="edge", color=sns.color_palette()[i % 10], edgecolor="black")
+        ax.set_xscale("log")
+        ax.set_yscale("log")
+        ax.set_title(f"Distribution for {metric}")
+        ax.set_xlabel("Latency (us)")
+        ax.set_ylabel("Frequency")
+
+        line = f"  {metric}: n={buckets['count'].sum()}"
+        for pct in (50.0, 90.0, 99.0, 99.9, 99.99):
+            value = percentile(buckets, pct) / 1000.0
+            line += f" p{pct:g}={value:.3f}"
+            ax.axvline(value, color="black", linestyle=":", linewidth=1)
+        line += f" max={buckets['high_ns'].iloc[-1] / 1000.0:.3f}"
+        print(line)
+
+    plt.tight_layout()
+    plt.show()
+
+
+if len(sys.argv) > 1 and sys.argv[1] == "--hdr":
+    plot_hdr(sys.argv[2:])
+    sys.exit(0)
+
 # Set Seaborn theme
 sns.set_theme(style="darkgrid")
 
@@ -33,9 +33,11 @@ int main() {
     Sequencer sequencer{};
     
     //service 1 is camera service running at 1000/30 approx 30fps
-    sequencer.addService(camera_capture_service, 1, 98, 30, 1);
-    sequencer.addService(red_laser_detect, 1, 97, 35, 2);
-    sequencer.addService(config_update_service,1,96,2000,3);
+    sequencer.addService(camera_capture_service, 1, 98, 30, ServiceOptions{.name = "camera"});
+    sequencer.addService(red_laser_detect, 1, 97, 35, ServiceOptions{.name = "red_laser_detect"});
+    sequencer.addService(config_update_service,1,96,2000, ServiceOptions{.name = "config_update"});
+    // Config.json "services" retunes these by name while running
+    config_bind_sequencer(&sequencer);
 //warm up cache?
     for(int i=0;i<10;i++){
 camera_capture_service();
@@ -1,10 +1,11 @@
 #include "red_laser_service.hpp"
+#include "RtMutex.hpp"
 
 //default config
 
 
 HSVConfig config; 
-std::mutex config_mutex;
+RtMutex config_mutex{"config"};
 
     int delta_t(struct timespec *stop, struct timespec *start, struct timespec *delta_t)
     {
@@ -51,7 +52,7 @@ void red_laser_detect (){
     cv::Mat frame;
 
     {
-        std::lock_guard<std::mutex> lock(frame_mutex);
+        std::lock_guard<RtMutex> lock(frame_mutex);
         if (latest_frame.empty()) return;
         frame = latest_frame.clone();
     }
@@ -59,7 +60,7 @@ void red_laser_detect (){
     HSVConfig current_config;
 //get latest config in case if its updated
 {
-    std::lock_guard<std::mutex> lock(config_mutex);
+    std::lock_guard<RtMutex> lock(config_mutex);
     current_config = config;
 
 }
@@ -0,0 +1,135 @@
+/*
+ * release_latency_bench.cpp - release-to-running latency of each
+ * ReleasePrimitive
+ *
+ * Mirrors how the Sequencer releases a service: a releaser thread at the
+ * top SCHED_FIFO priority wakes on an absolute timer, stamps the time,
+ * post()s and goes back to sleep; a service thread at a lower SCHED_FIFO
+ * priority wait()s and stamps the time it starts running. The difference
+ * is the release latency.
+ *
+ * Each primitive is measured with both threads on the same core (the
+ * service can only run once the releaser blocks again) and on two
+ * different cores (a cross-core wakeup). Cross-core runs are skipped on a
+ * single-CPU machine. Without RT privileges the threads stay SCHED_OTHER
+ * and the numbers are only indicative.
+ *
+ * Build with: make release_latency_bench   (g++ --std=c++23 -Wall -Werror -pedantic -O2)
+ * Run with:   sudo ./release_latency_bench [releases per run]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <thread>
+
+#include "LatencyHistogram.hpp"
+#include "ReleasePrimitive.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr auto kReleaseSpacing = std::chrono::microseconds(500);
+
+// Pin the calling thread and give it a SCHED_FIFO priority
+static bool makeRealtime(int cpu, int priority)
+{
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    bool pinned = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+
+    struct sched_param param{};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 && pinned;
+}
+
+static void sleepUntil(Clock::time_point when)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+    struct timespec ts{};
+    ts.tv_sec  = ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+// Returns false if the threads could not be made SCHED_FIFO
+static bool measure(ReleasePrimitiveKind kind, int releaserCpu, int serviceCpu, int releases,
+                    LatencyHistogram& latency)
+{
+    ReleasePrimitive primitive(kind);
+    std::atomic<int64_t> postedNs{0};
+    std::atomic<bool> serviceReady{false};
+    std::atomic<bool> serviceRt{false};
+
+    std::jthread service([&]() {
+        serviceRt = makeRealtime(serviceCpu, sched_get_priority_max(SCHED_FIFO) - 1);
+        serviceReady = true;
+        for (int i = 0; i < releases; i++) {
+            primitive.wait();
+            auto now = Clock::now().time_since_epoch().count();
+            latency.recordSigned(now - postedNs.load(std::memory_order_acquire));
+        }
+    });
+
+    bool releaserRt = false;
+    std::jthread releaser([&]() {
+        releaserRt = makeRealtime(releaserCpu, sched_get_priority_max(SCHED_FIFO));
+        while (!serviceReady) {
+            std::this_thread::yield();
+        }
+        auto next = Clock::now() + kReleaseSpacing;
+        for (int i = 0; i < releases; i++) {
+            sleepUntil(next);
+            postedNs.store(Clock::now().time_since_epoch().count(), std::memory_order_release);
+            primitive.post();
+            next += kReleaseSpacing;
+        }
+    });
+
+    releaser.join();
+    service.join();
+    return releaserRt && serviceRt;
+}
+
+int main(int argc, char* argv[])
+{
+    int releases = argc > 1 ? std::atoi(argv[1]) : 5000;
+    if (releases <= 0) {
+        std::fprintf(stderr, "usage: %s [releases per run]\n", argv[0]);
+        return 1;
+    }
+    mlockall(MCL_CURRENT | MCL_FUTURE);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    std::printf("Release-to-running latency, %d releases every %lld us per run (us)\n",
+                releases, static_cast<long long>(kReleaseSpacing.count()));
+    std::printf("%-10s %-11s %9s %9s %9s %9s %9s\n", "primitive", "placement", "min", "p50", "p99", "p99.9", "max");
+
+    bool allRt = true;
+    for (auto kind : {ReleasePrimitiveKind::Semaphore, ReleasePrimitiveKind::Futex,
+                      ReleasePrimitiveKind::EventFd, ReleasePrimitiveKind::CondVar}) {
+        for (bool crossCore : {false, true}) {
+            if (crossCore && cpus < 2) {
+                std::printf("%-10s %-11s %9s\n", releasePrimitiveName(kind), "cross-core", "skipped (1 CPU)");
+                continue;
+            }
+            LatencyHistogram latency;
+            allRt &= measure(kind, 0, crossCore ? 1 : 0, releases, latency);
+            auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+            std::printf("%-10s %-11s %9.2f %9.2f %9.2f %9.2f %9.2f\n", releasePrimitiveName(kind),
+                        crossCore ? "cross-core" : "same-core", us(latency.min()),
+                        us(latency.valueAtPercentile(50.0)), us(latency.valueAtPercentile(99.0)),
+                        us(latency.valueAtPercentile(99.9)), us(latency.max()));
+        }
+    }
+    if (!allRt) {
+        std::puts("warning: could not switch to SCHED_FIFO (run as root); numbers are not RT numbers");
+    }
+    return 0;
+}
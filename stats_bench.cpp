@@ -0,0 +1,202 @@
+/*
+ * stats_bench.cpp - per-release cost of the Service timing statistics
+ *
+ * Compares the original mutex-protected statistics path (one lock in
+ * release() on the scheduler thread, two locks per execution on the
+ * service thread) with the lock-free path Service uses now (each release
+ * handed over through the SPSC ReleaseQueue, plus single-writer SeqLock
+ * snapshots).
+ *
+ * Each variant is measured twice:
+ *   uncontended - one thread performs the release side and the service
+ *                 side back to back
+ *   contended   - a "scheduler" thread and a "service" thread hammer their
+ *                 halves of the path concurrently, as they do at high
+ *                 release rates; the service side only counts a job once
+ *                 it has received a release, and a release that finds the
+ *                 queue full is retried rather than dropped
+ *
+ * Build with: make stats_bench   (g++ --std=c++23 -Wall -Werror -pedantic -O2)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#include "ServiceStats.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int kIterations = 2000000;
+
+// The statistics path as it was: every access under _statsMutex
+class MutexStats
+{
+public:
+    bool releaseSide(Clock::time_point now, long long latenessUs)
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        _releaseTime = now;
+        if (latenessUs < _minLatenessUs) _minLatenessUs = latenessUs;
+        if (latenessUs > _maxLatenessUs) _maxLatenessUs = latenessUs;
+        _sumLatenessUs += latenessUs;
+        _countLateness++;
+        return true;
+    }
+
+    bool serviceSide(Clock::time_point start, long long execTimeUs)
+    {
+        Clock::time_point localReleaseTime;
+        {
+            std::lock_guard<std::mutex> lock(_statsMutex);
+            localReleaseTime = _releaseTime;
+        }
+        long long startJitterUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            start - localReleaseTime).count();
+
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        if (startJitterUs < _minStartJitterUs) _minStartJitterUs = startJitterUs;
+        if (startJitterUs > _maxStartJitterUs) _maxStartJitterUs = startJitterUs;
+        _sumStartJitterUs += startJitterUs;
+        _countStartJitter++;
+        if (execTimeUs < _minExecTimeUs) _minExecTimeUs = execTimeUs;
+        if (execTimeUs > _maxExecTimeUs) _maxExecTimeUs = execTimeUs;
+        _sumExecTimeUs += execTimeUs;
+        _countExecTime++;
+        return true;
+    }
+
+    size_t samples()
+    {
+        std::lock_guard<std::mutex> lock(_statsMutex);
+        return _countExecTime;
+    }
+
+private:
+    std::mutex _statsMutex;
+    Clock::time_point _releaseTime;
+    long long _minLatenessUs = std::numeric_limits<long long>::max();
+    long long _maxLatenessUs = 0;
+    long long _sumLatenessUs = 0;
+    size_t    _countLateness = 0;
+    long long _minStartJitterUs = std::numeric_limits<long long>::max();
+    long long _maxStartJitterUs = 0;
+    long long _sumStartJitterUs = 0;
+    size_t    _countStartJitter = 0;
+    long long _minExecTimeUs = std::numeric_limits<long long>::max();
+    long long _maxExecTimeUs = 0;
+    long long _sumExecTimeUs = 0;
+    size_t    _countExecTime = 0;
+};
+
+// The statistics path Service uses now: release() pushes the release
+// instants, the service thread pops them before each job
+class LockFreeStats
+{
+public:
+    // False if the queue is full (Service drops the release)
+    bool releaseSide(Clock::time_point now, long long latenessUs)
+    {
+        _releaseWorking.lateness.add(latenessUs);
+        _releaseWorking.lastLateness = latenessUs;
+        int64_t nowNs = now.time_since_epoch().count();
+        bool queued = _releaseQueue.push({nowNs, nowNs});
+        _releaseStats.store(_releaseWorking);
+        return queued;
+    }
+
+    // False if no release is queued (the service thread would still wait)
+    bool serviceSide(Clock::time_point start, long long execTimeUs)
+    {
+        ReleaseQueue::Entry entry;
+        if (!_releaseQueue.pop(entry)) {
+            return false;
+        }
+        Clock::time_point localReleaseTime{Clock::duration(entry.releasedNs)};
+        long long startJitterUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            start - localReleaseTime).count();
+
+        _execWorking.startJitter.add(startJitterUs);
+        _execWorking.execTime.add(execTimeUs);
+        _execStats.store(_execWorking);
+        return true;
+    }
+
+    size_t samples()
+    {
+        return _execStats.load().execTime.count;
+    }
+
+private:
+    ReleaseQueue            _releaseQueue;
+    alignas(64) ReleaseStats _releaseWorking;
+    SeqLock<ReleaseStats>   _releaseStats;
+    alignas(64) ExecutionStats _execWorking;
+    SeqLock<ExecutionStats> _execStats;
+};
+
+// ns per release with both halves on one thread
+template<typename Stats>
+double uncontended()
+{
+    Stats stats;
+    auto now = Clock::now();
+    auto begin = Clock::now();
+    for (int i = 0; i < kIterations; i++) {
+        stats.releaseSide(now, i & 63);
+        stats.serviceSide(now, i & 127);
+    }
+    auto end = Clock::now();
+    if (stats.samples() != static_cast<size_t>(kIterations)) {
+        std::puts("sample count mismatch");
+    }
+    return std::chrono::duration<double, std::nano>(end - begin).count() / kIterations;
+}
+
+// ns per release with the two halves on two threads
+template<typename Stats>
+double contended()
+{
+    Stats stats;
+    std::atomic<int> ready{0};
+    auto now = Clock::now();
+
+    auto worker = [&](bool releaseSide) {
+        ready++;
+        while (ready.load() < 2) {
+        }
+        for (int i = 0; i < kIterations; i++) {
+            if (releaseSide) {
+                while (!stats.releaseSide(now, i & 63)) {
+                    std::this_thread::yield(); // queue full: let the service side drain it
+                }
+            } else {
+                while (!stats.serviceSide(now, i & 127)) {
+                    std::this_thread::yield(); // nothing released yet
+                }
+            }
+        }
+    };
+
+    auto begin = Clock::now();
+    {
+        std::jthread scheduler(worker, true);
+        std::jthread service(worker, false);
+    }
+    auto end = Clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / kIterations;
+}
+
+int main()
+{
+    std::printf("Per-release statistics overhead (%d releases)\n", kIterations);
+    std::printf("%-22s %14s %14s\n", "variant", "uncontended", "contended");
+    std::printf("%-22s %11.1f ns %11.1f ns\n", "mutex (before)",
+                uncontended<MutexStats>(), contended<MutexStats>());
+    std::printf("%-22s %11.1f ns %11.1f ns\n", "lock-free (after)",
+                uncontended<LockFreeStats>(), contended<LockFreeStats>());
+    return 0;
+}
@@ -0,0 +1,345 @@
+/*
+ * trace_export.cpp - convert a TraceBuffer.hpp trace file to Chrome Trace
+ * Event JSON, for chrome://tracing or ui.perfetto.dev
+ *
+ * Tracks:
+ *   "Services" - one track per service: a slice per job (start -> end),
+ *                instants for releases and overruns
+ *   "CPUs"     - one track per CPU: the same jobs on the CPU they started
+ *                on. A job preempted by a higher-priority one on the same
+ *                CPU shows the preempting job nested inside it.
+ *   "Markers"  - one track per marker id, an instant per traceMarker()
+ *
+ * The input is streamed and every event is written out as soon as it is
+ * read; only the open job of each service is kept, so memory does not
+ * grow with the length of the run. The viewers sort events themselves.
+ *
+ * Build with: make trace_export   (g++ --std=c++23 -Wall -Werror -pedantic -O2)
+ * Run with:   ./trace_export final4.trace [final4.json]   (default: stdout)
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "TraceBuffer.hpp"
+
+enum TrackGroup
+{
+    kServices = 1,
+    kCpus     = 2,
+    kMarkers  = 3
+};
+
+// Buffered JSON writer; numbers go through to_chars, not printf
+class JsonOut
+{
+public:
+    explicit JsonOut(std::FILE* file)
+      : _file(file)
+    {
+        _buffer.reserve(kFlushSize + 4096);
+    }
+
+    ~JsonOut()
+    {
+        flush();
+    }
+
+    JsonOut& raw(const char* text)
+    {
+        _buffer.append(text);
+        return *this;
+    }
+
+    JsonOut& number(uint64_t value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        _buffer.append(digits, result.ptr);
+        return *this;
+    }
+
+    JsonOut& signedNumber(int64_t value)
+    {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        _buffer.append(digits, result.ptr);
+        return *this;
+    }
+
+    // ns as a microsecond value with three decimals, exactly
+    JsonOut& micros(uint64_t ns)
+    {
+        number(ns / 1000);
+        char fraction[5] = {'.', static_cast<char>('0' + ns % 1000 / 100), static_cast<char>('0' + ns % 100 / 10),
+                            static_cast<char>('0' + ns % 10), '\0'};
+        return raw(fraction);
+    }
+
+    JsonOut& string(const std::string& text)
+    {
+        _buffer.push_back('"');
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                _buffer.push_back('\\');
+                _buffer.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                _buffer.append(escaped);
+            } else {
+                _buffer.push_back(c);
+            }
+        }
+        _buffer.push_back('"');
+        return *this;
+    }
+
+    // Start the next element of traceEvents
+    JsonOut& event()
+    {
+        raw(_first ? "\n{" : ",\n{");
+        _first = false;
+        if (_buffer.size() >= kFlushSize) {
+            flush();
+        }
+        return *this;
+    }
+
+    void flush()
+    {
+        std::fwrite(_buffer.data(), 1, _buffer.size(), _file);
+        _buffer.clear();
+    }
+
+private:
+    static constexpr size_t kFlushSize = 1 << 20;
+
+    std::FILE*  _file;
+    std::string _buffer;
+    bool        _first = true;
+};
+
+struct OpenJob
+{
+    uint64_t startNs;
+    uint64_t intendedNs;
+    uint16_t cpu;
+};
+
+class ChromeTraceWriter
+{
+public:
+    explicit ChromeTraceWriter(std::FILE* file)
+      : _out(file)
+    {
+        _out.raw("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+        _processName(kServices, "Services");
+        _processName(kCpus, "CPUs");
+        _processName(kMarkers, "Markers");
+    }
+
+    ~ChromeTraceWriter()
+    {
+        _out.raw("\n]}\n");
+    }
+
+    void nameSource(uint16_t source, const std::string& name)
+    {
+        _names[source] = name;
+        _threadName(kServices, source, name);
+    }
+
+    void add(const TraceEvent& event)
+    {
+        _events++;
+        switch (event.type) {
+        case TraceEventType::Release:
+            _instant(kServices, event.source, "release", event.timestampNs);
+            if (event.value != 0) {
+                _out.raw(",\"args\":{\"lateness_ns\":")
+                    .signedNumber(static_cast<int64_t>(event.timestampNs - event.value))
+                    .raw("}");
+            }
+            _out.raw("}");
+            break;
+        case TraceEventType::Overrun:
+            _instant(kServices, event.source, "overrun", event.timestampNs);
+            _out.raw(",\"args\":{\"outstanding\":").number(event.value).raw("}}");
+            break;
+        case TraceEventType::Marker:
+            if (_markers.insert(event.source).second) {
+                _threadName(kMarkers, event.source, "marker " + std::to_string(event.source));
+            }
+            _instant(kMarkers, event.source, "marker", event.timestampNs);
+            _out.raw(",\"args\":{\"value\":").number(event.value).raw("}}");
+            break;
+        case TraceEventType::Start:
+            if (!_open.insert_or_assign(event.source, OpenJob{event.timestampNs, event.value, event.cpu}).second) {
+                _unmatched++; // its end was dropped
+            }
+            break;
+        case TraceEventType::End: {
+            auto job = _open.find(event.source);
+            if (job == _open.end()) {
+                _unmatched++;
+                break;
+            }
+            _job(event.source, job->second, event);
+            _open.erase(job);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    uint64_t events() const { return _events; }
+    uint64_t jobs() const { return _jobs; }
+    uint64_t unmatched() const { return _unmatched + _open.size(); }
+
+private:
+    void _processName(int pid, const char* name)
+    {
+        _out.event().raw("\"ph\":\"M\",\"name\":\"process_name\",\"pid\":").number(pid)
+            .raw(",\"args\":{\"name\":\"").raw(name).raw("\"}}");
+    }
+
+    void _threadName(int pid, uint64_t tid, const std::string& name)
+    {
+        _out.event().raw("\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":").number(pid)
+            .raw(",\"tid\":").number(tid).raw(",\"args\":{\"name\":").string(name).raw("}}");
+    }
+
+    // Leaves the object open for args
+    void _instant(int pid, uint64_t tid, const char* name, uint64_t timestampNs)
+    {
+        _out.event().raw("\"ph\":\"i\",\"s\":\"t\",\"name\":\"").raw(name).raw("\",\"pid\":").number(pid)
+            .raw(",\"tid\":").number(tid).raw(",\"ts\":").micros(timestampNs);
+    }
+
+    const std::string& _name(uint16_t source)
+    {
+        auto name = _names.find(source);
+        if (name == _names.end()) {
+            name = _names.emplace(source, "service" + std::to_string(source)).first;
+        }
+        return name->second;
+    }
+
+    // One complete ("X") slice on the service track and one on the CPU track
+    void _job(uint16_t source, const OpenJob& job, const TraceEvent& end)
+    {
+        _jobs++;
+        if (_cpus.insert(job.cpu).second) {
+            _threadName(kCpus, job.cpu, "cpu" + std::to_string(job.cpu));
+        }
+        uint64_t duration = end.timestampNs > job.startNs ? end.timestampNs - job.startNs : 0;
+        const std::string& name = _name(source);
+        for (int pid : {kServices, kCpus}) {
+            _out.event().raw("\"ph\":\"X\",\"name\":").string(name).raw(",\"pid\":").number(pid)
+                .raw(",\"tid\":").number(pid == kServices ? source : job.cpu)
+                .raw(",\"ts\":").micros(job.startNs).raw(",\"dur\":").micros(duration)
+                .raw(",\"args\":{\"cpu\":").number(job.cpu).raw(",\"end_cpu\":").number(end.cpu);
+            if (job.intendedNs != 0) {
+                _out.raw(",\"start_latency_ns\":").signedNumber(static_cast<int64_t>(job.startNs - job.intendedNs))
+                    .raw(",\"response_ns\":").signedNumber(static_cast<int64_t>(end.timestampNs - job.intendedNs));
+            }
+            _out.raw("}}");
+        }
+    }
+
+    JsonOut                                   _out;
+    std::unordered_map<uint16_t, std::string> _names;
+    std::unordered_map<uint16_t, OpenJob>     _open;
+    std::unordered_set<uint16_t>              _cpus;
+    std::unordered_set<uint16_t>              _markers;
+    uint64_t                                  _events = 0;
+    uint64_t                                  _jobs = 0;
+    uint64_t                                  _unmatched = 0;
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3) {
+        std::fprintf(stderr, "usage: %s <trace file> [output.json]\n", argv[0]);
+        return 1;
+    }
+    auto begin = std::chrono::steady_clock::now();
+
+    std::FILE* in = std::fopen(argv[1], "rb");
+    if (in == nullptr) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    char magic[sizeof(kTraceMagic)];
+    uint32_t header[2];
+    if (std::fread(magic, sizeof(magic), 1, in) != 1 || std::fread(header, sizeof(header), 1, in) != 1
+        || std::memcmp(magic, kTraceMagic, sizeof(magic)) != 0) {
+        std::fprintf(stderr, "%s: not a trace file\n", argv[1]);
+        return 1;
+    }
+    if (header[0] != kTraceVersion || header[1] != sizeof(TraceEvent)) {
+        std::fprintf(stderr, "%s: trace version %u with %u-byte events, expected %u with %zu\n", argv[1],
+                     header[0], header[1], kTraceVersion, sizeof(TraceEvent));
+        return 1;
+    }
+
+    std::FILE* out = argc == 3 ? std::fopen(argv[2], "w") : stdout;
+    if (out == nullptr) {
+        std::perror(argv[2]);
+        return 1;
+    }
+
+    uint64_t events = 0;
+    uint64_t jobs = 0;
+    uint64_t unmatched = 0;
+    {
+        ChromeTraceWriter writer(out);
+        std::vector<TraceEvent> chunk(4096);
+        size_t count;
+        while ((count = std::fread(chunk.data(), sizeof(TraceEvent), chunk.size(), in)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                if (chunk[i].type != TraceEventType::SourceName) {
+                    writer.add(chunk[i]);
+                    continue;
+                }
+                // The name follows its record, padded to whole records and
+                // possibly split across chunks
+                std::string name(chunk[i].value, '\0');
+                size_t records = (name.size() + sizeof(TraceEvent) - 1) / sizeof(TraceEvent);
+                std::vector<TraceEvent> padded(records);
+                size_t fromChunk = std::min(records, count - i - 1);
+                std::memcpy(padded.data(), &chunk[i + 1], fromChunk * sizeof(TraceEvent));
+                if (fromChunk < records
+                    && std::fread(&padded[fromChunk], sizeof(TraceEvent), records - fromChunk, in)
+                           != records - fromChunk) {
+                    break; // truncated file
+                }
+                std::memcpy(name.data(), padded.data(), name.size());
+                writer.nameSource(chunk[i].source, name);
+                i += fromChunk;
+            }
+        }
+        events = writer.events();
+        jobs = writer.jobs();
+        unmatched = writer.unmatched();
+    }
+    std::fclose(in);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::fprintf(stderr, "%llu events, %llu jobs (%llu unmatched start/end) in %.2f s\n",
+                 static_cast<unsigned long long>(events), static_cast<unsigned long long>(jobs),
+                 static_cast<unsigned long long>(unmatched), seconds);
+    return 0;
+}